@@ -33,7 +33,9 @@
 #include <sstream>
 #include <string>
 #include <unistd.h>
+#include <fcntl.h>
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 #include <alsa/asoundlib.h>
@@ -41,6 +43,7 @@
 #define BUF_SIZE 441
 #define CHN_SIZE 2
 #define SAMPLING_RATE 44100
+#define SWEEP_FIFO "wavex.fifo"
 
 #ifndef INCLUDED_MAINAPP
 	#include "wavex-console_main.hpp"
@@ -48,6 +51,7 @@
 #endif
 
 int wXs_hardware_setup_playback(snd_pcm_t*, snd_pcm_hw_params_t*, unsigned int*);
+void wXs_read_sweep(int, std::string&, double*);
 
 void GuiFrame::onWorkerStart()
 {
@@ -92,10 +96,26 @@ wxThread::ExitCode WorkerThread::Entry ()
 	clock_t old_clk, new_clk;
 	double timer_ms = 0.0;
 	old_clk = clock();
+	// In Bode mode, xoscilloscope drives output 1 through SWEEP_FIFO: while
+	// a sweep frequency is set, output 1 is a sine at that frequency and at
+	// the amplitude of output 1, whatever its settings. New frequencies
+	// take effect at the first sample of the next buffer, with a continuous
+	// phase, so that the circuit settles as fast as possible.
+	mkfifo(SWEEP_FIFO, S_IRUSR | S_IWUSR);
+	int sweep_fifo = open(SWEEP_FIFO, O_RDONLY | O_NONBLOCK);
+	std::string sweep_line;
+	double sweep_f = 0.0, sweep_phase = 0.0;
 	while (true) {
 		bzero(buf, BUF_SIZE * CHN_SIZE * sizeof(int16_t));
+		wXs_read_sweep(sweep_fifo, sweep_line, &sweep_f);
 		for (int i = 0; i < BUF_SIZE * CHN_SIZE; i = i + 2) {
-			if (this->wave_parameters->output_1) {
+			if (sweep_f > 0.0) {
+				A = this->wave_parameters->A1 / this->wave_parameters->y1_vps;
+				buf[i] = (int16_t) floor(A * sin(8.0*atan(1.0)*sweep_phase));
+				sweep_phase += sweep_f * dt;
+				if (sweep_phase >= 1.0)
+					sweep_phase -= 1.0;
+			} else if (this->wave_parameters->output_1) {
 				f = this->wave_parameters->f1;
 				A = this->wave_parameters->A1 / this->wave_parameters->y1_vps;
 				d = this->wave_parameters->delay1;
@@ -149,6 +169,8 @@ wxThread::ExitCode WorkerThread::Entry ()
 		nr_written = snd_pcm_writei(device_handle, buf, BUF_SIZE);
 		if (nr_written == -EPIPE) {
 			free(buf);
+			if (sweep_fifo >= 0)
+				close(sweep_fifo);
 			snd_pcm_close(device_handle);
 			snd_pcm_hw_params_free(device_parameters);
 			usleep(10000);
@@ -174,6 +196,8 @@ wxThread::ExitCode WorkerThread::Entry ()
 
 		if (parent_frame->thread_shall_be_cancelled || TestDestroy()) {
 			free(buf);
+			if (sweep_fifo >= 0)
+				close(sweep_fifo);
 			snd_pcm_close(device_handle);
 			snd_pcm_hw_params_free(device_parameters);
 			parent_frame->thread_is_running = false;
@@ -185,6 +209,8 @@ wxThread::ExitCode WorkerThread::Entry ()
 	}
 
 	free(buf);
+	if (sweep_fifo >= 0)
+		close(sweep_fifo);
 	snd_pcm_close(device_handle);
 	snd_pcm_hw_params_free(device_parameters);
 	parent_frame->thread_is_running = false;
@@ -192,6 +218,29 @@ wxThread::ExitCode WorkerThread::Entry ()
 	return (wxThread::ExitCode) 0;
 }
 
+// Reads whatever the sweep pipe holds, without waiting: each complete line
+// "b<frequency>" sets the sweep frequency, the latest one winning; "b0"
+// gives output 1 back to its own settings.
+void wXs_read_sweep(int sweep_fifo, std::string& sweep_line, double* sweep_f)
+{
+	char chunk[256];
+	long int nr_read;
+
+	if (sweep_fifo < 0)
+		return;
+	while ((nr_read = read(sweep_fifo, chunk, sizeof(chunk))) > 0) {
+		sweep_line.append(chunk, nr_read);
+		size_t end;
+		while ((end = sweep_line.find('\n')) != std::string::npos) {
+			if (sweep_line[0] == 'b')
+				*sweep_f = atof(sweep_line.c_str() + 1);
+			sweep_line.erase(0, end + 1);
+		}
+	}
+
+	return;
+}
+
 
 int wXs_hardware_setup_playback(snd_pcm_t* device_handle, snd_pcm_hw_params_t* device_parameters, unsigned int* sample_rate)
 {
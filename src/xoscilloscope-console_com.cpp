@@ -95,38 +95,105 @@ wxThread::ExitCode WorkerThread::Entry ()
 
 	while (true) {
 		bzero(paramsg, (SOCKET_BUFFER_SIZE - 2) * sizeof(char));
+		bzero(buf, SOCKET_BUFFER_SIZE * sizeof(char));
 		n = read(newsockfd, buf, (SOCKET_BUFFER_SIZE - 2) * sizeof(char));
-		if (buf[0] == 'g') {
+		if (buf[0] == 'i') {
+			unsigned int rate, period, buffer, channels = 2;
+			if (sscanf(buf + 1, "%u,%u,%u,%u", &rate, &period, &buffer, &channels) >= 3) {
+				this->data_container->engine_sample_rate = rate;
+				this->data_container->engine_period_size = period;
+				this->data_container->engine_buffer_size = buffer;
+				this->data_container->nr_channels = (channels < 2)? 2 : ((channels > MAX_CHANNELS)? MAX_CHANNELS : channels);
+				this->parent_frame->CallAfter(&GuiFrame::onEngineInfo);
+			} else {
+				std::cerr << "Communication error: malformed engine information...\n";
+			}
+			sprintf(paramsg, "n");
+			write(newsockfd, paramsg, (SOCKET_BUFFER_SIZE - 2) * sizeof(char));
+		} else if (buf[0] == 'g') {
+			unsigned long xruns, lost_frames, overruns, dropped_frames;
+			double waveform_rate = 0.0;
+			unsigned int trigger_status = 0;
+			double m[8];
+			int nr_fields = sscanf(buf + 1, "%lu,%lu,%lu,%lu,%lf,%u,%lf,%lf,%lf,%lf,%lf,%lf,%lf,%lf", &xruns, &lost_frames, &overruns, &dropped_frames, &waveform_rate, &trigger_status, m, m + 1, m + 2, m + 3, m + 4, m + 5, m + 6, m + 7);
+			if (nr_fields >= 4) {
+				// Measurements, if any, follow the status.
+				bool measured = (nr_fields == 14);
+				bool changed = (measured != this->data_container->engine_measured);
+				if (measured && memcmp(m, this->data_container->engine_measurements, sizeof(m))) {
+					memcpy(this->data_container->engine_measurements, m, sizeof(m));
+					changed = true;
+				}
+				if (changed || (xruns != this->data_container->engine_xruns) || (overruns != this->data_container->engine_overruns) || (waveform_rate != this->data_container->engine_waveform_rate) || (trigger_status != this->data_container->engine_trigger_status)) {
+					this->data_container->engine_measured = measured;
+					this->data_container->engine_xruns = xruns;
+					this->data_container->engine_lost_frames = lost_frames;
+					this->data_container->engine_overruns = overruns;
+					this->data_container->engine_dropped_frames = dropped_frames;
+					this->data_container->engine_waveform_rate = waveform_rate;
+					this->data_container->engine_trigger_status = trigger_status;
+					this->parent_frame->CallAfter(&GuiFrame::onEngineStatus);
+				}
+			}
 			if (this->data_container->send_changes) {
 				char temp_string[32];
 				std::string tdiv_msg = this->data_container->list_tdiv[this->data_container->tdiv_idx];
-				std::string y1dv_msg;
-				if (this->data_container->y1_vps != 1.0)
-					y1dv_msg = this->data_container->list_ydiv_volts[this->data_container->y1div_idx];
-				else
-					y1dv_msg = this->data_container->list_ydiv_samples[this->data_container->y1div_idx];
-				std::string y2dv_msg;
-				if (this->data_container->y2_vps != 1.0)
-					y2dv_msg = this->data_container->list_ydiv_volts[this->data_container->y2div_idx];
-				else
-					y2dv_msg = this->data_container->list_ydiv_samples[this->data_container->y2div_idx];
+				std::string ydv_msg[MAX_CHANNELS];
+				for (unsigned int c = 0; c < this->data_container->nr_channels; c++) {
+					if (this->data_container->y_vps[c] != 1.0)
+						ydv_msg[c] = this->data_container->list_ydiv_volts[this->data_container->ydiv_idx[c]];
+					else
+						ydv_msg[c] = this->data_container->list_ydiv_samples[this->data_container->ydiv_idx[c]];
+				}
 				char edge = (this->data_container->trig_edge == 0)? 'r' : 'f';
 				int ch = this->data_container->trig_channel + 1;
 				sprintf(temp_string, "%+.2e", this->data_container->trig_level);
 				std::string trig_level_msg = temp_string;
 				bzero(temp_string, 32 * sizeof(char));
-				sprintf(temp_string, "%+.2e", this->data_container->y1_vps);
-				std::string y1factor_msg = temp_string;
-				bzero(temp_string, 32 * sizeof(char));
-				sprintf(temp_string, "%+.2e", this->data_container->y2_vps);
-				std::string y2factor_msg = temp_string;
-				bzero(temp_string, 32 * sizeof(char));
+				std::string yfactor_msg[MAX_CHANNELS];
+				for (unsigned int c = 0; c < this->data_container->nr_channels; c++) {
+					sprintf(temp_string, "%+.2e", this->data_container->y_vps[c]);
+					yfactor_msg[c] = temp_string;
+					bzero(temp_string, 32 * sizeof(char));
+				}
 				sprintf(temp_string, "%.3d", this->data_container->navg);
 				std::string navg_msg = temp_string;
 				bzero(temp_string, 32 * sizeof(char));
 
-				sprintf(paramsg, "y%s%s%s%c%d%s%s%s%s", tdiv_msg.c_str(), y1dv_msg.c_str(), y2dv_msg.c_str(), edge, ch, trig_level_msg.c_str(), y1factor_msg.c_str(), y2factor_msg.c_str(), navg_msg.c_str());
+				sprintf(paramsg, "y%s%s%s%c%d%s%s%s%s", tdiv_msg.c_str(), ydv_msg[0].c_str(), ydv_msg[1].c_str(), edge, ch, trig_level_msg.c_str(), yfactor_msg[0].c_str(), yfactor_msg[1].c_str(), navg_msg.c_str());
+				for (unsigned int c = 2; c < this->data_container->nr_channels; c++)
+					sprintf(paramsg + strlen(paramsg), "%s%s", ydv_msg[c].c_str(), yfactor_msg[c].c_str());
 				this->data_container->send_changes = false;
+			} else if (this->data_container->send_trigger_changes) {
+				sprintf(paramsg, "t%d,%d,%+.3e,%+.3e,%.3e,%.3e,%d,%.3e,%.3e", this->data_container->trig_type, this->data_container->trig_condition, this->data_container->trig_hysteresis, this->data_container->trig_level_high, this->data_container->trig_time_min, this->data_container->trig_time_max, this->data_container->trig_sweep, this->data_container->trig_holdoff, this->data_container->trig_auto_timeout);
+				this->data_container->send_trigger_changes = false;
+			} else if (this->data_container->send_position_changes) {
+				sprintf(paramsg, "o%.3f,%.3e", this->data_container->trig_position, this->data_container->trig_delay);
+				this->data_container->send_position_changes = false;
+			} else if (this->data_container->send_average_changes) {
+				sprintf(paramsg, "a%d,%d", this->data_container->avg_mode, this->data_container->acq_mode);
+				this->data_container->send_average_changes = false;
+			} else if (this->data_container->send_logic_changes) {
+				sprintf(paramsg, "l%u,%.3e", this->data_container->dig_window, this->data_container->dig_threshold);
+				this->data_container->send_logic_changes = false;
+			} else if (this->data_container->send_decoder_changes) {
+				sprintf(paramsg, "k%d,%d,%u", this->data_container->dec_type, this->data_container->dec_channel, this->data_container->dec_baud);
+				this->data_container->send_decoder_changes = false;
+			} else if (this->data_container->send_voltmeter_changes) {
+				sprintf(paramsg, "v%.3f", this->data_container->vm_interval);
+				this->data_container->send_voltmeter_changes = false;
+			} else if (this->data_container->send_measure_changes) {
+				sprintf(paramsg, "e%d", (this->data_container->measure)? 1 : 0);
+				this->data_container->send_measure_changes = false;
+			} else if (this->data_container->send_spectrum_changes) {
+				sprintf(paramsg, "f%d,%d,%d", this->data_container->spec_window, this->data_container->spec_scale, this->data_container->spec_averaging);
+				this->data_container->send_spectrum_changes = false;
+			} else if (this->data_container->send_bode_changes) {
+				sprintf(paramsg, "b%.3f,%.3f,%u", this->data_container->bode_start, this->data_container->bode_stop, this->data_container->bode_points);
+				this->data_container->send_bode_changes = false;
+			} else if (this->data_container->arm_command) {
+				sprintf(paramsg, "r");
+				this->data_container->arm_command = false;
 			} else if (this->data_container->pause_command) {
 				sprintf(paramsg, "p");
 			} else if (this->data_container->save_command) {
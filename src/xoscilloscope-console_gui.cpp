@@ -78,6 +78,8 @@ GuiFrame::GuiFrame (const wxString& title)
 
 	statictext_title_y2dv = new wxStaticText(this, wxID_ANY, wxT("Vertical scale, channel 2"), wxDefaultPosition, wxDefaultSize, 0);
 	statictext_title_y2dv->SetFont(font_bold);
+	choice_second_channel = new wxChoice(this, EVENT_CHOICE_SECOND_CHANNEL, wxDefaultPosition, wxDefaultSize);
+	Connect(EVENT_CHOICE_SECOND_CHANNEL, wxEVT_CHOICE, wxCommandEventHandler(GuiFrame::selectSecondChannel));
 	staticline_title_y2dv = new wxStaticLine(this, wxID_ANY, wxDefaultPosition, wxSize(-1,1));
 	statictext_value_y2dv = new wxStaticText(this, wxID_ANY, "", wxDefaultPosition, wxDefaultSize, 0);
 	statictext_value_y2dv->SetFont(font_bold);
@@ -96,9 +98,9 @@ GuiFrame::GuiFrame (const wxString& title)
 	statictext_title_trig->SetFont(font_bold);
 	staticline_title_trig = new wxStaticLine(this, wxID_ANY, wxDefaultPosition, wxSize(-1,1));
 	wxArrayString	m_list_channels;
-	m_list_channels.Add(wxT("Ch. 1"));
-	m_list_channels.Add(wxT("Ch. 2"));
-	radiobox_trig_chan = new wxRadioBox(this, EVENT_CHOSEN_TRIG_CHAN, wxT("Trigger channel"), wxDefaultPosition, wxDefaultSize, m_list_channels, 0, wxRA_SPECIFY_ROWS);
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++)
+		m_list_channels.Add(wxString::Format("Ch. %u", c + 1));
+	radiobox_trig_chan = new wxRadioBox(this, EVENT_CHOSEN_TRIG_CHAN, wxT("Trigger channel"), wxDefaultPosition, wxDefaultSize, m_list_channels, 2, wxRA_SPECIFY_ROWS);
 	Connect(EVENT_CHOSEN_TRIG_CHAN, wxEVT_RADIOBOX, wxCommandEventHandler(GuiFrame::selectTrigChan));
 	wxArrayString	m_list_trigedges;
 	m_list_trigedges.Add(wxT("Rising"));
@@ -108,6 +110,51 @@ GuiFrame::GuiFrame (const wxString& title)
 	statictext_label_trig = new wxStaticText(this, wxID_ANY, wxT("Trigger level:"), wxDefaultPosition, wxDefaultSize, 0);
 	spinner_trig_level = new wxSpinCtrlDouble(this, EVENT_SPINNER_TRIG_LVL, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, -1.0, 1.0, 0.0);
 	Connect(EVENT_SPINNER_TRIG_LVL, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::selectTrigLevel));
+	statictext_label_trig_type = new wxStaticText(this, wxID_ANY, wxT("Trigger type:"), wxDefaultPosition, wxDefaultSize, 0);
+	wxArrayString	m_list_trigtypes;
+	m_list_trigtypes.Add(wxT("Edge"));
+	m_list_trigtypes.Add(wxT("Pulse width"));
+	m_list_trigtypes.Add(wxT("Window"));
+	m_list_trigtypes.Add(wxT("Slew rate"));
+	choice_trig_type = new wxChoice(this, EVENT_CHOICE_TRIG_TYPE, wxDefaultPosition, wxDefaultSize, m_list_trigtypes);
+	Connect(EVENT_CHOICE_TRIG_TYPE, wxEVT_CHOICE, wxCommandEventHandler(GuiFrame::selectTrigType));
+	wxArrayString	m_list_trigconditions;
+	m_list_trigconditions.Add(wxT("Shorter than max."));
+	m_list_trigconditions.Add(wxT("Longer than min."));
+	m_list_trigconditions.Add(wxT("Between min. and max."));
+	choice_trig_condition = new wxChoice(this, EVENT_CHOICE_TRIG_CONDITION, wxDefaultPosition, wxDefaultSize, m_list_trigconditions);
+	Connect(EVENT_CHOICE_TRIG_CONDITION, wxEVT_CHOICE, wxCommandEventHandler(GuiFrame::selectTrigCondition));
+	statictext_label_trig_hyst = new wxStaticText(this, wxID_ANY, wxT("Hysteresis:"), wxDefaultPosition, wxDefaultSize, 0);
+	spinner_trig_hysteresis = new wxSpinCtrlDouble(this, EVENT_SPINNER_TRIG_HYST, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, 0.0, 1.0, 0.0);
+	Connect(EVENT_SPINNER_TRIG_HYST, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::selectTrigHysteresis));
+	statictext_label_trig_high = new wxStaticText(this, wxID_ANY, wxT("Upper level:"), wxDefaultPosition, wxDefaultSize, 0);
+	spinner_trig_level_high = new wxSpinCtrlDouble(this, EVENT_SPINNER_TRIG_LVL_HIGH, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, -1.0, 1.0, 0.0);
+	Connect(EVENT_SPINNER_TRIG_LVL_HIGH, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::selectTrigLevelHigh));
+	statictext_label_trig_time = new wxStaticText(this, wxID_ANY, wxT("Min./max. time (us):"), wxDefaultPosition, wxDefaultSize, 0);
+	spinner_trig_time_min = new wxSpinCtrlDouble(this, EVENT_SPINNER_TRIG_TIME_MIN, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, 0.0, 1e6, 0.0, 10.0);
+	Connect(EVENT_SPINNER_TRIG_TIME_MIN, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::selectTrigTimes));
+	spinner_trig_time_max = new wxSpinCtrlDouble(this, EVENT_SPINNER_TRIG_TIME_MAX, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, 0.0, 1e6, 0.0, 10.0);
+	Connect(EVENT_SPINNER_TRIG_TIME_MAX, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::selectTrigTimes));
+	statictext_label_trig_sweep = new wxStaticText(this, wxID_ANY, wxT("Sweep:"), wxDefaultPosition, wxDefaultSize, 0);
+	wxArrayString	m_list_trigsweeps;
+	m_list_trigsweeps.Add(wxT("Auto"));
+	m_list_trigsweeps.Add(wxT("Normal"));
+	m_list_trigsweeps.Add(wxT("Single"));
+	choice_trig_sweep = new wxChoice(this, EVENT_CHOICE_TRIG_SWEEP, wxDefaultPosition, wxDefaultSize, m_list_trigsweeps);
+	Connect(EVENT_CHOICE_TRIG_SWEEP, wxEVT_CHOICE, wxCommandEventHandler(GuiFrame::selectTrigSweep));
+	button_trig_arm = new wxButton(this, EVENT_BUTTON_TRIG_ARM, wxT("Arm"), wxDefaultPosition, wxDefaultSize);
+	Connect(EVENT_BUTTON_TRIG_ARM, wxEVT_COMMAND_BUTTON_CLICKED, wxCommandEventHandler(GuiFrame::armTrigger));
+	statictext_label_trig_holdoff = new wxStaticText(this, wxID_ANY, wxT("Holdoff/auto (ms):"), wxDefaultPosition, wxDefaultSize, 0);
+	spinner_trig_holdoff = new wxSpinCtrlDouble(this, EVENT_SPINNER_TRIG_HOLDOFF, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, 0.0, 1e4, 0.0, 0.1);
+	Connect(EVENT_SPINNER_TRIG_HOLDOFF, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::selectTrigHoldoff));
+	spinner_trig_auto_timeout = new wxSpinCtrlDouble(this, EVENT_SPINNER_TRIG_AUTO_TIMEOUT, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, 0.0, 1e4, 100.0, 10.0);
+	Connect(EVENT_SPINNER_TRIG_AUTO_TIMEOUT, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::selectTrigHoldoff));
+	statictext_label_trig_position = new wxStaticText(this, wxID_ANY, wxT("Trigger point (%):"), wxDefaultPosition, wxDefaultSize, 0);
+	spinner_trig_position = new wxSpinCtrlDouble(this, EVENT_SPINNER_TRIG_POSITION, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, 0.0, 100.0, 50.0, 5.0);
+	Connect(EVENT_SPINNER_TRIG_POSITION, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::selectTrigPosition));
+	statictext_label_trig_delay = new wxStaticText(this, wxID_ANY, wxT("Delay (ms):"), wxDefaultPosition, wxDefaultSize, 0);
+	spinner_trig_delay = new wxSpinCtrlDouble(this, EVENT_SPINNER_TRIG_DELAY, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, 0.0, 1e4, 0.0, 0.1);
+	Connect(EVENT_SPINNER_TRIG_DELAY, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::selectTrigPosition));
 
 	statictext_title_misc = new wxStaticText(this, wxID_ANY, wxT("General controls"), wxDefaultPosition, wxDefaultSize, 0);
 	statictext_title_misc->SetFont(font_bold);
@@ -127,6 +174,60 @@ GuiFrame::GuiFrame (const wxString& title)
 	m_list_averages.Add(wxT(CHOICES_AVERAGES_5));
 	choice_averages = new wxChoice(this, EVENT_CHOICE_AVERAGES, wxDefaultPosition, wxDefaultSize, m_list_averages);
 	Connect(EVENT_CHOICE_AVERAGES, wxEVT_CHOICE, wxCommandEventHandler(GuiFrame::selectChoiceAverages));
+	wxArrayString	m_list_average_modes;
+	m_list_average_modes.Add(wxT("Running average"));
+	m_list_average_modes.Add(wxT("Exponential average"));
+	m_list_average_modes.Add(wxT("Peak detect"));
+	m_list_average_modes.Add(wxT("Envelope"));
+	choice_average_mode = new wxChoice(this, EVENT_CHOICE_AVERAGE_MODE, wxDefaultPosition, wxDefaultSize, m_list_average_modes);
+	Connect(EVENT_CHOICE_AVERAGE_MODE, wxEVT_CHOICE, wxCommandEventHandler(GuiFrame::selectChoiceAverageMode));
+	statictext_label_logic = new wxStaticText(this, wxID_ANY, wxT("Logic window (samples) / threshold:"), wxDefaultPosition, wxDefaultSize, 0);
+	spinner_logic_window = new wxSpinCtrl(this, EVENT_SPINNER_LOGIC_WINDOW, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 1, 4096, 24);
+	Connect(EVENT_SPINNER_LOGIC_WINDOW, wxEVT_SPINCTRL, wxCommandEventHandler(GuiFrame::selectLogicDetection));
+	spinner_logic_threshold = new wxSpinCtrlDouble(this, EVENT_SPINNER_LOGIC_THRESHOLD, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, 0.0, 32768.0, 8192.0, 256.0);
+	Connect(EVENT_SPINNER_LOGIC_THRESHOLD, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::selectLogicDetection));
+	statictext_label_decoder = new wxStaticText(this, wxID_ANY, wxT("Decoder / baud:"), wxDefaultPosition, wxDefaultSize, 0);
+	wxArrayString	m_list_decoders;
+	m_list_decoders.Add(wxT("None"));
+	m_list_decoders.Add(wxT("UART on ch1"));
+	m_list_decoders.Add(wxT("UART on ch2"));
+	m_list_decoders.Add(wxT("I2C (ch1 clock, ch2 data)"));
+	m_list_decoders.Add(wxT("Pulse code on ch1"));
+	m_list_decoders.Add(wxT("Pulse code on ch2"));
+	choice_decoder = new wxChoice(this, EVENT_CHOICE_DECODER, wxDefaultPosition, wxDefaultSize, m_list_decoders);
+	Connect(EVENT_CHOICE_DECODER, wxEVT_CHOICE, wxCommandEventHandler(GuiFrame::selectDecoder));
+	spinner_decoder_baud = new wxSpinCtrl(this, EVENT_SPINNER_DECODER_BAUD, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 1, 115200, 300);
+	Connect(EVENT_SPINNER_DECODER_BAUD, wxEVT_SPINCTRL, wxCommandEventHandler(GuiFrame::selectDecoder));
+	statictext_label_voltmeter = new wxStaticText(this, wxID_ANY, wxT("Voltmeter refresh (s):"), wxDefaultPosition, wxDefaultSize, 0);
+	spinner_voltmeter_interval = new wxSpinCtrlDouble(this, EVENT_SPINNER_VOLTMETER_INTERVAL, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, 0.05, 10.0, 0.5, 0.05);
+	Connect(EVENT_SPINNER_VOLTMETER_INTERVAL, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::selectVoltmeterInterval));
+	checkbox_measure = new wxCheckBox(this, EVENT_CHECKBOX_MEASURE, wxT("Measurements"), wxDefaultPosition, wxDefaultSize, 0);
+	Connect(EVENT_CHECKBOX_MEASURE, wxEVT_CHECKBOX, wxCommandEventHandler(GuiFrame::toggleMeasurements));
+	statictext_label_spectrum = new wxStaticText(this, wxID_ANY, wxT("Spectrum window / scale / averaging:"), wxDefaultPosition, wxDefaultSize, 0);
+	wxArrayString	m_list_spectrum_windows;
+	m_list_spectrum_windows.Add(wxT("Hann"));
+	m_list_spectrum_windows.Add(wxT("Blackman"));
+	m_list_spectrum_windows.Add(wxT("Flat top"));
+	choice_spectrum_window = new wxChoice(this, EVENT_CHOICE_SPECTRUM_WINDOW, wxDefaultPosition, wxDefaultSize, m_list_spectrum_windows);
+	Connect(EVENT_CHOICE_SPECTRUM_WINDOW, wxEVT_CHOICE, wxCommandEventHandler(GuiFrame::selectSpectrum));
+	wxArrayString	m_list_spectrum_scales;
+	m_list_spectrum_scales.Add(wxT("Linear"));
+	m_list_spectrum_scales.Add(wxT("dB"));
+	choice_spectrum_scale = new wxChoice(this, EVENT_CHOICE_SPECTRUM_SCALE, wxDefaultPosition, wxDefaultSize, m_list_spectrum_scales);
+	Connect(EVENT_CHOICE_SPECTRUM_SCALE, wxEVT_CHOICE, wxCommandEventHandler(GuiFrame::selectSpectrum));
+	wxArrayString	m_list_spectrum_averaging;
+	m_list_spectrum_averaging.Add(wxT("Latest frame"));
+	m_list_spectrum_averaging.Add(wxT("RMS average"));
+	m_list_spectrum_averaging.Add(wxT("Peak hold"));
+	choice_spectrum_averaging = new wxChoice(this, EVENT_CHOICE_SPECTRUM_AVERAGING, wxDefaultPosition, wxDefaultSize, m_list_spectrum_averaging);
+	Connect(EVENT_CHOICE_SPECTRUM_AVERAGING, wxEVT_CHOICE, wxCommandEventHandler(GuiFrame::selectSpectrum));
+	statictext_label_bode = new wxStaticText(this, wxID_ANY, wxT("Bode sweep from / to (Hz) / points:"), wxDefaultPosition, wxDefaultSize, 0);
+	spinner_bode_start = new wxSpinCtrlDouble(this, EVENT_SPINNER_BODE_START, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, 1.0, 20000.0, 20.0, 1.0);
+	Connect(EVENT_SPINNER_BODE_START, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::selectBodeSweep));
+	spinner_bode_stop = new wxSpinCtrlDouble(this, EVENT_SPINNER_BODE_STOP, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_VERTICAL, 10.0, 22000.0, 20000.0, 10.0);
+	Connect(EVENT_SPINNER_BODE_STOP, wxEVT_SPINCTRLDOUBLE, wxCommandEventHandler(GuiFrame::selectBodeSweep));
+	spinner_bode_points = new wxSpinCtrl(this, EVENT_SPINNER_BODE_POINTS, wxEmptyString, wxDefaultPosition, wxDefaultSize, wxSP_ARROW_KEYS, 2, 1000, 40);
+	Connect(EVENT_SPINNER_BODE_POINTS, wxEVT_SPINCTRL, wxCommandEventHandler(GuiFrame::selectBodeSweep));
 
 	wxBoxSizer *vbox_all = new wxBoxSizer(wxVERTICAL);
 		wxBoxSizer *hbox_tdtr_all = new wxBoxSizer(wxHORIZONTAL);
@@ -150,9 +251,37 @@ GuiFrame::GuiFrame (const wxString& title)
 				wxBoxSizer *hbox_trig_level = new wxBoxSizer(wxHORIZONTAL);
 				hbox_trig_level->Add(statictext_label_trig, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
 				hbox_trig_level->Add(spinner_trig_level, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_level->Add(statictext_label_trig_hyst, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_level->Add(spinner_trig_hysteresis, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				wxBoxSizer *hbox_trig_type = new wxBoxSizer(wxHORIZONTAL);
+				hbox_trig_type->Add(statictext_label_trig_type, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_type->Add(choice_trig_type, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_type->Add(statictext_label_trig_high, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_type->Add(spinner_trig_level_high, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				wxBoxSizer *hbox_trig_time = new wxBoxSizer(wxHORIZONTAL);
+				hbox_trig_time->Add(choice_trig_condition, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_time->Add(statictext_label_trig_time, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_time->Add(spinner_trig_time_min, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_time->Add(spinner_trig_time_max, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				wxBoxSizer *hbox_trig_sweep = new wxBoxSizer(wxHORIZONTAL);
+				hbox_trig_sweep->Add(statictext_label_trig_sweep, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_sweep->Add(choice_trig_sweep, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_sweep->Add(button_trig_arm, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_sweep->Add(statictext_label_trig_holdoff, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_sweep->Add(spinner_trig_holdoff, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_sweep->Add(spinner_trig_auto_timeout, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				wxBoxSizer *hbox_trig_position = new wxBoxSizer(wxHORIZONTAL);
+				hbox_trig_position->Add(statictext_label_trig_position, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_position->Add(spinner_trig_position, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_position->Add(statictext_label_trig_delay, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+				hbox_trig_position->Add(spinner_trig_delay, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
 			vbox_trig_all->Add(hbox_trig_title, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 			vbox_trig_all->Add(hbox_trig_radios, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 			vbox_trig_all->Add(hbox_trig_level, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+			vbox_trig_all->Add(hbox_trig_type, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+			vbox_trig_all->Add(hbox_trig_time, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+			vbox_trig_all->Add(hbox_trig_sweep, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+			vbox_trig_all->Add(hbox_trig_position, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 		hbox_tdtr_all->Add(vbox_tdiv_all, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 		hbox_tdtr_all->Add(vbox_trig_all, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 
@@ -180,6 +309,7 @@ GuiFrame::GuiFrame (const wxString& title)
 			wxBoxSizer *vbox_y2div_all = new wxBoxSizer(wxVERTICAL);
 				wxBoxSizer *hbox_y2div_title = new wxBoxSizer(wxHORIZONTAL);
 				hbox_y2div_title->Add(statictext_title_y2dv, 3, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+				hbox_y2div_title->Add(choice_second_channel, 0, wxALL | wxALIGN_CENTER_VERTICAL, 4);
 				hbox_y2div_title->Add(staticline_title_y2dv, 1, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
 				wxBoxSizer *hbox_y2div_btns = new wxBoxSizer(wxHORIZONTAL);
 					wxBoxSizer *vbox_y2div_left = new wxBoxSizer(wxVERTICAL);
@@ -209,15 +339,48 @@ GuiFrame::GuiFrame (const wxString& title)
 			hbox_misc_all->Add(button_save, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
 			hbox_misc_all->Add(button_togglemode, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
 			hbox_misc_all->Add(choice_averages, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+			hbox_misc_all->Add(choice_average_mode, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+			wxBoxSizer *hbox_misc_logic = new wxBoxSizer(wxHORIZONTAL);
+			hbox_misc_logic->Add(statictext_label_logic, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+			hbox_misc_logic->Add(spinner_logic_window, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+			hbox_misc_logic->Add(spinner_logic_threshold, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+			wxBoxSizer *hbox_misc_decoder = new wxBoxSizer(wxHORIZONTAL);
+			hbox_misc_decoder->Add(statictext_label_decoder, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+			hbox_misc_decoder->Add(choice_decoder, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+			hbox_misc_decoder->Add(spinner_decoder_baud, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+			wxBoxSizer *hbox_misc_voltmeter = new wxBoxSizer(wxHORIZONTAL);
+			hbox_misc_voltmeter->Add(statictext_label_voltmeter, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+			hbox_misc_voltmeter->Add(spinner_voltmeter_interval, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+			hbox_misc_voltmeter->Add(checkbox_measure, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+			wxBoxSizer *hbox_misc_spectrum = new wxBoxSizer(wxHORIZONTAL);
+			hbox_misc_spectrum->Add(statictext_label_spectrum, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+			hbox_misc_spectrum->Add(choice_spectrum_window, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+			hbox_misc_spectrum->Add(choice_spectrum_scale, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+			hbox_misc_spectrum->Add(choice_spectrum_averaging, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+			wxBoxSizer *hbox_misc_bode = new wxBoxSizer(wxHORIZONTAL);
+			hbox_misc_bode->Add(statictext_label_bode, 0, wxALL | wxALIGN_CENTER_VERTICAL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 8);
+			hbox_misc_bode->Add(spinner_bode_start, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+			hbox_misc_bode->Add(spinner_bode_stop, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
+			hbox_misc_bode->Add(spinner_bode_points, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 4);
 		vbox_misc_all->Add(hbox_misc_title, 0, wxALL | wxEXPAND | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 		vbox_misc_all->Add(hbox_misc_all, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_misc_all->Add(hbox_misc_logic, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_misc_all->Add(hbox_misc_decoder, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_misc_all->Add(hbox_misc_voltmeter, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_misc_all->Add(hbox_misc_spectrum, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
+		vbox_misc_all->Add(hbox_misc_bode, 0, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 	vbox_all->Add(hbox_tdtr_all, 1, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 	vbox_all->Add(hbox_y1y2_all, 1, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 	vbox_all->Add(vbox_misc_all, 1, wxALL | wxRESERVE_SPACE_EVEN_IF_HIDDEN, 1);
 
 	this->SetSizer(vbox_all);
-	SetSize(1080,550,650,500);
-	SetMinSize(wxSize(650,500));
+	CreateStatusBar(4);
+	SetStatusText("Waiting for the oscilloscope engine...");
+	SetStatusText("No frames lost", 1);
+	SetStatusText("", 2);
+	SetStatusText("", 3);
+	SetSize(1080,550,650,855);
+	SetMinSize(wxSize(650,855));
 	Show();
 	GuiFrame::initializeConstants();
 
@@ -284,7 +447,7 @@ void GuiFrame::updateTdiv()
 
 void GuiFrame::knobY1dvUp (wxCommandEvent& WXUNUSED(event))
 {
-	int yi = this->scope_parameters->y1div_idx;
+	int yi = this->scope_parameters->ydiv_idx[0];
 	int yi_max = this->scope_parameters->ydiv_size;
 	if (yi == yi_max - 1) {
 		return;
@@ -297,7 +460,7 @@ void GuiFrame::knobY1dvUp (wxCommandEvent& WXUNUSED(event))
 	} else {
 		yi++;
 	}
-	this->scope_parameters->y1div_idx = yi;
+	this->scope_parameters->ydiv_idx[0] = yi;
 	this->setSpinnerTrigLevelExtrema();
 	this->scope_parameters->send_changes = true;
 	this->updateY1div();
@@ -307,7 +470,7 @@ void GuiFrame::knobY1dvUp (wxCommandEvent& WXUNUSED(event))
 
 void GuiFrame::knobY1dvDw (wxCommandEvent& WXUNUSED(event))
 {
-	int yi = this->scope_parameters->y1div_idx;
+	int yi = this->scope_parameters->ydiv_idx[0];
 	int yi_max = this->scope_parameters->ydiv_size;
 	if (yi == 0) {
 		return;
@@ -320,7 +483,7 @@ void GuiFrame::knobY1dvDw (wxCommandEvent& WXUNUSED(event))
 	} else {
 		yi--;
 	}
-	this->scope_parameters->y1div_idx = yi;
+	this->scope_parameters->ydiv_idx[0] = yi;
 	this->setSpinnerTrigLevelExtrema();
 	this->scope_parameters->send_changes = true;
 	this->updateY1div();
@@ -331,10 +494,10 @@ void GuiFrame::knobY1dvDw (wxCommandEvent& WXUNUSED(event))
 void GuiFrame::updateY1div()
 {
 	std::stringstream	displayed_value;
-	if (this->scope_parameters->y1_vps != 1.0) {
-		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_volts_txt[this->scope_parameters->y1div_idx] << " / div";
+	if (this->scope_parameters->y_vps[0] != 1.0) {
+		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_volts_txt[this->scope_parameters->ydiv_idx[0]] << " / div";
 	} else {
-		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_samples_txt[this->scope_parameters->y1div_idx] << " / div";
+		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_samples_txt[this->scope_parameters->ydiv_idx[0]] << " / div";
 	}
 	this->statictext_value_y1dv->SetLabel(displayed_value.str());
 	return;
@@ -342,7 +505,7 @@ void GuiFrame::updateY1div()
 
 void GuiFrame::knobY2dvUp (wxCommandEvent& WXUNUSED(event))
 {
-	int yi = this->scope_parameters->y2div_idx;
+	int yi = this->scope_parameters->ydiv_idx[this->scope_parameters->second_channel];
 	int yi_max = this->scope_parameters->ydiv_size;
 	if (yi == yi_max - 1) {
 		return;
@@ -355,7 +518,7 @@ void GuiFrame::knobY2dvUp (wxCommandEvent& WXUNUSED(event))
 	} else {
 		yi++;
 	}
-	this->scope_parameters->y2div_idx = yi;
+	this->scope_parameters->ydiv_idx[this->scope_parameters->second_channel] = yi;
 	this->setSpinnerTrigLevelExtrema();
 	this->scope_parameters->send_changes = true;
 	this->updateY2div();
@@ -365,7 +528,7 @@ void GuiFrame::knobY2dvUp (wxCommandEvent& WXUNUSED(event))
 
 void GuiFrame::knobY2dvDw (wxCommandEvent& WXUNUSED(event))
 {
-	int yi = this->scope_parameters->y2div_idx;
+	int yi = this->scope_parameters->ydiv_idx[this->scope_parameters->second_channel];
 	int yi_max = this->scope_parameters->ydiv_size;
 	if (yi == 0) {
 		return;
@@ -378,7 +541,7 @@ void GuiFrame::knobY2dvDw (wxCommandEvent& WXUNUSED(event))
 	} else {
 		yi--;
 	}
-	this->scope_parameters->y2div_idx = yi;
+	this->scope_parameters->ydiv_idx[this->scope_parameters->second_channel] = yi;
 	this->setSpinnerTrigLevelExtrema();
 	this->scope_parameters->send_changes = true;
 	this->updateY2div();
@@ -389,15 +552,49 @@ void GuiFrame::knobY2dvDw (wxCommandEvent& WXUNUSED(event))
 void GuiFrame::updateY2div()
 {
 	std::stringstream	displayed_value;
-	if (this->scope_parameters->y2_vps != 1.0) {
-		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_volts_txt[this->scope_parameters->y2div_idx] << " / div";
+	unsigned int	chan = this->scope_parameters->second_channel;
+	if (this->scope_parameters->y_vps[chan] != 1.0) {
+		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_volts_txt[this->scope_parameters->ydiv_idx[chan]] << " / div";
 	} else {
-		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_samples_txt[this->scope_parameters->y2div_idx] << " / div";
+		displayed_value << "V scale: " << this->scope_parameters->list_ydiv_samples_txt[this->scope_parameters->ydiv_idx[chan]] << " / div";
 	}
 	this->statictext_value_y2dv->SetLabel(displayed_value.str());
 	return;
 }
 
+void GuiFrame::selectSecondChannel(wxCommandEvent& WXUNUSED(event))
+{
+	unsigned int chan = this->choice_second_channel->GetSelection() + 1;
+	if ((chan < 1) || (chan >= this->scope_parameters->nr_channels))
+		return;
+	this->scope_parameters->second_channel = chan;
+
+	int yi = this->scope_parameters->ydiv_idx[chan];
+	if ((this->scope_parameters->mode == 'a') || (this->scope_parameters->mode == 'x')) {
+		this->button_y2dv_up->Enable(yi < this->scope_parameters->ydiv_size - 1);
+		this->button_y2dv_dw->Enable(yi > 0);
+	}
+	this->updateY2div();
+	this->updateCalibrationCh2();
+
+	return;
+}
+
+void GuiFrame::updateCalibrationCh2()
+{
+	double vps = this->scope_parameters->y_vps[this->scope_parameters->second_channel];
+	if (vps == 1.0) {
+		this->statictext_calibration_ch2->SetLabel("No calibration");
+	} else {
+		char	display_label[32];
+		sprintf(display_label, "%d units/V", (int) lrint(1.0 / vps));
+		this->statictext_calibration_ch2->SetLabel(display_label);
+	}
+	this->statictext_calibration_ch2->Refresh();
+
+	return;
+}
+
 void GuiFrame::selectTrigChan(wxCommandEvent& WXUNUSED(event))
 {
 	this->scope_parameters->trig_channel = this->radiobox_trig_chan->GetSelection();
@@ -423,10 +620,14 @@ void GuiFrame::selectTrigLevel(wxCommandEvent& WXUNUSED(event))
 void GuiFrame::setSpinnerTrigLevelExtrema()
 {
 	unsigned int chan = this->scope_parameters->trig_channel;
-	double ymax = 4.0 * atof(this->scope_parameters->list_ydiv_samples[(chan == 0)? this->scope_parameters->y1div_idx : this->scope_parameters->y2div_idx].c_str());
+	double ymax = 4.0 * atof(this->scope_parameters->list_ydiv_samples[this->scope_parameters->ydiv_idx[chan]].c_str());
 	double previous_value = this->spinner_trig_level->GetValue();
 	this->spinner_trig_level->SetRange(-ymax, ymax);
 	this->spinner_trig_level->SetIncrement(ymax / 100);
+	this->spinner_trig_level_high->SetRange(-ymax, ymax);
+	this->spinner_trig_level_high->SetIncrement(ymax / 100);
+	this->spinner_trig_hysteresis->SetRange(0.0, ymax);
+	this->spinner_trig_hysteresis->SetIncrement(ymax / 100);
 	if (fabs(previous_value) > ymax) {
 		wxCommandEvent ev(wxEVT_SPINCTRLDOUBLE, EVENT_SPINNER_TRIG_LVL);
 		spinner_trig_level->GetEventHandler()->ProcessEvent(ev);
@@ -435,6 +636,117 @@ void GuiFrame::setSpinnerTrigLevelExtrema()
 	return;
 }
 
+void GuiFrame::selectTrigType(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->trig_type = this->choice_trig_type->GetSelection();
+	this->updateTrigType();
+	this->scope_parameters->send_trigger_changes = true;
+	return;
+}
+
+void GuiFrame::selectTrigCondition(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->trig_condition = this->choice_trig_condition->GetSelection();
+	this->scope_parameters->send_trigger_changes = true;
+	return;
+}
+
+void GuiFrame::selectTrigHysteresis(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->trig_hysteresis = this->spinner_trig_hysteresis->GetValue();
+	this->scope_parameters->send_trigger_changes = true;
+	return;
+}
+
+void GuiFrame::selectTrigLevelHigh(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->trig_level_high = this->spinner_trig_level_high->GetValue();
+	this->scope_parameters->send_trigger_changes = true;
+	return;
+}
+
+void GuiFrame::selectTrigTimes(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->trig_time_min = this->spinner_trig_time_min->GetValue() * 1e-6;
+	this->scope_parameters->trig_time_max = this->spinner_trig_time_max->GetValue() * 1e-6;
+	this->scope_parameters->send_trigger_changes = true;
+	return;
+}
+
+void GuiFrame::selectTrigSweep(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->trig_sweep = this->choice_trig_sweep->GetSelection();
+	this->updateTrigType();
+	this->scope_parameters->send_trigger_changes = true;
+	return;
+}
+
+void GuiFrame::armTrigger(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->arm_command = true;
+	return;
+}
+
+void GuiFrame::selectTrigHoldoff(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->trig_holdoff = this->spinner_trig_holdoff->GetValue() * 1e-3;
+	this->scope_parameters->trig_auto_timeout = this->spinner_trig_auto_timeout->GetValue() * 1e-3;
+	this->scope_parameters->send_trigger_changes = true;
+	return;
+}
+
+// The trigger point is given as the percentage of the trace preceding it;
+// the delay moves the trace past the trigger by the given time.
+void GuiFrame::selectTrigPosition(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->trig_position = this->spinner_trig_position->GetValue() * 1e-2;
+	this->scope_parameters->trig_delay = this->spinner_trig_delay->GetValue() * 1e-3;
+	this->scope_parameters->send_position_changes = true;
+	return;
+}
+
+// The edge selector reads as the pulse polarity for pulse-width triggers,
+// and as leaving/entering for window triggers; the upper level and the
+// time condition are only enabled for the trigger types that use them.
+// Sweep settings and the trigger point apply to analog and digital modes;
+// the auto timeout is only enabled for auto sweeps, and the arm button for
+// single sweeps.
+void GuiFrame::updateTrigType()
+{
+	const char*	edge_labels[4][2] = {{"Rising", "Falling"}, {"Positive", "Negative"}, {"Leaving", "Entering"}, {"Rising", "Falling"}};
+	int		type = this->scope_parameters->trig_type;
+	bool		analog = (this->scope_parameters->mode == 'a');
+	bool		two_levels = analog && ((type == 2) || (type == 3));
+	bool		timed = analog && ((type == 1) || (type == 3));
+	bool		triggered = analog || (this->scope_parameters->mode == 'd');
+	int		sweep = this->scope_parameters->trig_sweep;
+
+	this->radiobox_trig_edge->SetString(0, edge_labels[type][0]);
+	this->radiobox_trig_edge->SetString(1, edge_labels[type][1]);
+	this->statictext_label_trig_type->Enable(analog);
+	this->choice_trig_type->Enable(analog);
+	this->statictext_label_trig_hyst->Enable(analog);
+	this->spinner_trig_hysteresis->Enable(analog);
+	this->statictext_label_trig_high->Enable(two_levels);
+	this->spinner_trig_level_high->Enable(two_levels);
+	this->choice_trig_condition->Enable(timed);
+	this->statictext_label_trig_time->Enable(timed);
+	this->spinner_trig_time_min->Enable(timed);
+	this->spinner_trig_time_max->Enable(timed);
+	this->statictext_label_trig_sweep->Enable(triggered);
+	this->choice_trig_sweep->Enable(triggered);
+	this->button_trig_arm->Enable(triggered && (sweep == 2));
+	this->statictext_label_trig_holdoff->Enable(triggered);
+	this->spinner_trig_holdoff->Enable(triggered);
+	this->spinner_trig_auto_timeout->Enable(triggered && (sweep == 0));
+	this->statictext_label_trig_position->Enable(triggered);
+	this->spinner_trig_position->Enable(triggered);
+	this->statictext_label_trig_delay->Enable(triggered);
+	this->spinner_trig_delay->Enable(triggered);
+
+	return;
+}
+
 void GuiFrame::selectChoiceAverages(wxCommandEvent& WXUNUSED(event))
 {
 	switch (this->choice_averages->GetSelection()) {
@@ -465,17 +777,101 @@ void GuiFrame::selectChoiceAverages(wxCommandEvent& WXUNUSED(event))
 	return;
 }
 
+// Running averages are exact over the latest waveforms; exponential ones
+// need the memory of a single trace, whatever the number of averages. Peak
+// detect and envelope keep the extrema of each screen column, the latter
+// over as many waveforms as would be averaged (all of them with no
+// averages).
+void GuiFrame::selectChoiceAverageMode(wxCommandEvent& WXUNUSED(event))
+{
+	int selection = this->choice_average_mode->GetSelection();
+	this->scope_parameters->avg_mode = (selection == 1)? 1 : 0;
+	this->scope_parameters->acq_mode = (selection > 1)? selection - 1 : 0;
+	this->scope_parameters->send_average_changes = true;
+
+	return;
+}
+
+// Digital mode: a channel is at level 1 when the standard deviation of its
+// latest samples, over the given window, reaches the threshold (in units of
+// a 16-bit converter).
+void GuiFrame::selectLogicDetection(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->dig_window = this->spinner_logic_window->GetValue();
+	this->scope_parameters->dig_threshold = this->spinner_logic_threshold->GetValue();
+	this->scope_parameters->send_logic_changes = true;
+
+	return;
+}
+
+// Digital mode: protocol decoder (UART, I2C or pulse code) and its bit rate;
+// the choices are listed by type, then channel.
+void GuiFrame::selectDecoder(wxCommandEvent& WXUNUSED(event))
+{
+	int selection = this->choice_decoder->GetSelection();
+	this->scope_parameters->dec_type = (selection == 0)? 0 : ((selection <= 2)? 1 : ((selection == 3)? 2 : 3));
+	this->scope_parameters->dec_channel = ((selection == 2) || (selection == 5))? 1 : 0;
+	this->scope_parameters->dec_baud = this->spinner_decoder_baud->GetValue();
+	this->scope_parameters->send_decoder_changes = true;
+
+	return;
+}
+
+// Voltmeter mode: time over which each reading is taken.
+void GuiFrame::selectVoltmeterInterval(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->vm_interval = this->spinner_voltmeter_interval->GetValue();
+	this->scope_parameters->send_voltmeter_changes = true;
+
+	return;
+}
+
+// Analog mode: automatic measurements of every triggered waveform.
+void GuiFrame::toggleMeasurements(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->measure = this->checkbox_measure->GetValue();
+	this->scope_parameters->send_measure_changes = true;
+
+	return;
+}
+
+// Spectrum mode: window of the transforms, linear or dB magnitudes, and
+// averaging of the spectra over the number of averages (RMS) or since the
+// last change (peak hold).
+void GuiFrame::selectSpectrum(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->spec_window = this->choice_spectrum_window->GetSelection();
+	this->scope_parameters->spec_scale = this->choice_spectrum_scale->GetSelection();
+	this->scope_parameters->spec_averaging = this->choice_spectrum_averaging->GetSelection();
+	this->scope_parameters->send_spectrum_changes = true;
+
+	return;
+}
+
+// Bode mode: the frequency response of channel 2 with respect to channel 1,
+// at log-spaced points between the two frequencies, the generator (wavex)
+// being driven by the engine.
+void GuiFrame::selectBodeSweep(wxCommandEvent& WXUNUSED(event))
+{
+	this->scope_parameters->bode_start = this->spinner_bode_start->GetValue();
+	this->scope_parameters->bode_stop = this->spinner_bode_stop->GetValue();
+	this->scope_parameters->bode_points = this->spinner_bode_points->GetValue();
+	this->scope_parameters->send_bode_changes = true;
+
+	return;
+}
+
 void GuiFrame::changedCalibrationCh1(wxCommandEvent& WXUNUSED(event))
 {
 	unsigned int user_value = (unsigned int) wxGetNumberFromUser("Insert calibration factor, i.e. an integer number corresponding to 1 Volt.", "[1,65535]", "Set calibration for Channel 1", 1, 1, 65535, this, wxDefaultPosition);
 
 	char	*display_label = (char*) malloc(32 * sizeof(char));
 	if (user_value == 1) {
-		this->scope_parameters->y1_vps = 1.0;
+		this->scope_parameters->y_vps[0] = 1.0;
 		this->statictext_calibration_ch1->SetLabel("No calibration");
 		this->statictext_calibration_ch1->Refresh();
 	} else {
-		this->scope_parameters->y1_vps = 1.0 / (double) user_value;
+		this->scope_parameters->y_vps[0] = 1.0 / (double) user_value;
 		sprintf(display_label, "%d units/V", user_value);
 		this->statictext_calibration_ch1->SetLabel(display_label);
 		this->statictext_calibration_ch1->Refresh();
@@ -489,23 +885,17 @@ void GuiFrame::changedCalibrationCh1(wxCommandEvent& WXUNUSED(event))
 
 void GuiFrame::changedCalibrationCh2(wxCommandEvent& WXUNUSED(event))
 {
-	unsigned int user_value = (unsigned int) wxGetNumberFromUser("Insert calibration factor, i.e. an integer number corresponding to 1 Volt.", "[1,65535]", "Set calibration for Channel 2", 1, 1, 65535, this, wxDefaultPosition);
-
-	char	*display_label = (char*) malloc(32 * sizeof(char));
-	if (user_value == 1) {
-		this->scope_parameters->y2_vps = 1.0;
-		this->statictext_calibration_ch2->SetLabel("No calibration");
-		this->statictext_calibration_ch2->Refresh();
-	} else {
-		this->scope_parameters->y2_vps = 1.0 / (double) user_value;
-		sprintf(display_label, "%d units/V", user_value);
-		this->statictext_calibration_ch2->SetLabel(display_label);
-		this->statictext_calibration_ch2->Refresh();
-	}
-	this->updateY1div();
+	unsigned int chan = this->scope_parameters->second_channel;
+	unsigned int user_value = (unsigned int) wxGetNumberFromUser("Insert calibration factor, i.e. an integer number corresponding to 1 Volt.", "[1,65535]", wxString::Format("Set calibration for Channel %u", chan + 1), 1, 1, 65535, this, wxDefaultPosition);
+
+	if (user_value == 1)
+		this->scope_parameters->y_vps[chan] = 1.0;
+	else
+		this->scope_parameters->y_vps[chan] = 1.0 / (double) user_value;
+	this->updateCalibrationCh2();
+	this->updateY2div();
 	this->scope_parameters->send_changes = true;
 
-	free(display_label);
 	return;
 }
 
@@ -523,6 +913,15 @@ void GuiFrame::initializeConstants()
 	this->scope_parameters->list_tdiv_txt.resize(16, "");
 	this->scope_parameters->list_tdiv = {"5e-5", "1e-4", "2e-4", "5e-4", "1e-3", "2e-3", "5e-3", "1e-2", "2e-2", "5e-2", "1e-1", "2e-1", "5e-1", "1e+0", "2e+0", "5e+0"};
 	this->scope_parameters->list_tdiv_txt = {"50 us", "0.1 ms", "0.2 ms", "0.5 ms", "1 ms", "2 ms", "5 ms", "10 ms", "20 ms", "50 ms", "0.1 s", "0.2 s", "0.5 s", "1 s", "2 s", "5 s"};
+	this->scope_parameters->engine_sample_rate = 44100;
+	this->scope_parameters->engine_period_size = 0;
+	this->scope_parameters->engine_buffer_size = 0;
+	this->scope_parameters->engine_xruns = 0;
+	this->scope_parameters->engine_lost_frames = 0;
+	this->scope_parameters->engine_overruns = 0;
+	this->scope_parameters->engine_dropped_frames = 0;
+	this->scope_parameters->engine_waveform_rate = 0.0;
+	this->scope_parameters->engine_trigger_status = 0;
 	this->scope_parameters->tdiv_idx = 4;
 
 	this->scope_parameters->ydiv_size = 12;
@@ -534,14 +933,30 @@ void GuiFrame::initializeConstants()
 	this->scope_parameters->list_ydiv_samples_txt = {"4 units", "8 units", "20 units", "40 units", "80 units", "200 units", "400 units", "800 units", "2000 units", "4000 units", "8000 units", "20000 units"};
 	this->scope_parameters->list_ydiv_volts = {"1e-3", "2e-3", "5e-3", "1e-2", "2e-2", "5e-2", "1e-1", "2e-1", "5e-1", "1e+0", "2e+0", "5e+1"};
 	this->scope_parameters->list_ydiv_volts_txt = {"1 mV", "2 mV", "5 mV", "10 mV", "20 mV", "50 mV", "100 mV", "200 mV", "500 mV", "1 V", "2 V", "5 V"};
-	this->scope_parameters->y1div_idx = this->scope_parameters->ydiv_size - 2;
-	this->scope_parameters->y2div_idx = this->scope_parameters->ydiv_size - 2;
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++) {
+		this->scope_parameters->ydiv_idx[c] = this->scope_parameters->ydiv_size - 2;
+		this->scope_parameters->y_vps[c] = 1.0;
+	}
+	this->scope_parameters->nr_channels = 2;
+	this->scope_parameters->second_channel = 1;
 
 	this->scope_parameters->trig_edge = 0;
 	this->scope_parameters->trig_channel = 0;
 	this->scope_parameters->trig_level = 0.0;
-	this->scope_parameters->y1_vps = 1.0;
-	this->scope_parameters->y2_vps = 1.0;
+	this->scope_parameters->trig_type = 0;
+	this->scope_parameters->trig_condition = 1;
+	this->scope_parameters->trig_hysteresis = 0.0;
+	this->scope_parameters->trig_level_high = 0.0;
+	this->scope_parameters->trig_time_min = 0.0;
+	this->scope_parameters->trig_time_max = 0.0;
+	this->scope_parameters->trig_sweep = 0;
+	this->scope_parameters->trig_holdoff = 0.0;
+	this->scope_parameters->trig_auto_timeout = 0.1;
+	this->scope_parameters->send_trigger_changes = false;
+	this->scope_parameters->arm_command = false;
+	this->scope_parameters->trig_position = 0.5;
+	this->scope_parameters->trig_delay = 0.0;
+	this->scope_parameters->send_position_changes = false;
 
 	this->updateTdiv();
 	this->updateY1div();
@@ -551,25 +966,190 @@ void GuiFrame::initializeConstants()
 		this->button_tdiv_up->Disable();
 	else if (this->scope_parameters->tdiv_idx == 0)
 		this->button_tdiv_dw->Disable();
-	if (this->scope_parameters->y1div_idx == this->scope_parameters->ydiv_size - 1)
+	if (this->scope_parameters->ydiv_idx[0] == this->scope_parameters->ydiv_size - 1)
 		this->button_y1dv_up->Disable();
-	else if (this->scope_parameters->y1div_idx == 0)
+	else if (this->scope_parameters->ydiv_idx[0] == 0)
 		this->button_y1dv_dw->Disable();
-	if (this->scope_parameters->y2div_idx == this->scope_parameters->ydiv_size - 1)
+	if (this->scope_parameters->ydiv_idx[1] == this->scope_parameters->ydiv_size - 1)
 		this->button_y2dv_up->Disable();
-	else if (this->scope_parameters->y2div_idx == 0)
+	else if (this->scope_parameters->ydiv_idx[1] == 0)
 		this->button_y2dv_dw->Disable();
 
 	this->scope_parameters->navg = 1;
 	this->choice_averages->SetSelection(0);
+	this->scope_parameters->avg_mode = 0;
+	this->scope_parameters->acq_mode = 0;
+	this->scope_parameters->send_average_changes = false;
+	this->choice_average_mode->SetSelection(0);
+	this->scope_parameters->dig_window = 24;
+	this->scope_parameters->dig_threshold = 8192.0;
+	this->scope_parameters->send_logic_changes = false;
+	this->statictext_label_logic->Disable();
+	this->spinner_logic_window->Disable();
+	this->spinner_logic_threshold->Disable();
+	this->scope_parameters->dec_type = 0;
+	this->scope_parameters->dec_channel = 0;
+	this->scope_parameters->dec_baud = 300;
+	this->scope_parameters->send_decoder_changes = false;
+	this->choice_decoder->SetSelection(0);
+	this->statictext_label_decoder->Disable();
+	this->choice_decoder->Disable();
+	this->spinner_decoder_baud->Disable();
+	this->scope_parameters->vm_interval = 0.5;
+	this->scope_parameters->send_voltmeter_changes = false;
+	this->statictext_label_voltmeter->Disable();
+	this->spinner_voltmeter_interval->Disable();
+	this->scope_parameters->measure = false;
+	this->scope_parameters->send_measure_changes = false;
+	this->scope_parameters->engine_measured = false;
+	this->checkbox_measure->SetValue(false);
+	this->scope_parameters->spec_window = 0;
+	this->scope_parameters->spec_scale = 1;
+	this->scope_parameters->spec_averaging = 0;
+	this->scope_parameters->send_spectrum_changes = false;
+	this->choice_spectrum_window->SetSelection(0);
+	this->choice_spectrum_scale->SetSelection(1);
+	this->choice_spectrum_averaging->SetSelection(0);
+	this->statictext_label_spectrum->Disable();
+	this->choice_spectrum_window->Disable();
+	this->choice_spectrum_scale->Disable();
+	this->choice_spectrum_averaging->Disable();
+	this->scope_parameters->bode_start = 20.0;
+	this->scope_parameters->bode_stop = 20000.0;
+	this->scope_parameters->bode_points = 40;
+	this->scope_parameters->send_bode_changes = false;
+	this->statictext_label_bode->Disable();
+	this->spinner_bode_start->Disable();
+	this->spinner_bode_stop->Disable();
+	this->spinner_bode_points->Disable();
 
 	this->radiobox_trig_chan->SetSelection(this->scope_parameters->trig_channel);
 	this->radiobox_trig_edge->SetSelection(this->scope_parameters->trig_edge);
+	this->choice_trig_type->SetSelection(this->scope_parameters->trig_type);
+	this->choice_trig_condition->SetSelection(this->scope_parameters->trig_condition);
+	this->choice_trig_sweep->SetSelection(this->scope_parameters->trig_sweep);
+	this->updateTrigType();
 	this->setSpinnerTrigLevelExtrema();
+	this->rebuildChannels();
+
+	return;
+}
+
+
+void GuiFrame::onEngineInfo()
+{
+	char	status_text[128];
+	sprintf(status_text, "Engine: %u Hz, period %u frames, buffer %u frames, %u channels", this->scope_parameters->engine_sample_rate, this->scope_parameters->engine_period_size, this->scope_parameters->engine_buffer_size, this->scope_parameters->nr_channels);
+	SetStatusText(status_text);
+	this->rebuildTimebase();
+	this->rebuildChannels();
+	return;
+}
 
+// Frames lost by the sound card (device overruns) and frames dropped by the
+// engine (capture ring overruns) both show that the engine is falling behind;
+// the waveform capture rate tells how many triggered waveforms per second
+// the engine is able to acquire, followed by the state of normal and single
+// sweeps.
+void GuiFrame::onEngineStatus()
+{
+	const char*	sweep_status[4] = {"", ", waiting for trigger", ", single shot armed", ", single shot taken"};
+	char	status_text[128];
+	if ((this->scope_parameters->engine_xruns == 0) && (this->scope_parameters->engine_overruns == 0))
+		sprintf(status_text, "No frames lost");
+	else
+		sprintf(status_text, "Lost %lu frames in %lu overruns, dropped %lu frames in %lu ring overruns", this->scope_parameters->engine_lost_frames, this->scope_parameters->engine_xruns, this->scope_parameters->engine_dropped_frames, this->scope_parameters->engine_overruns);
+	SetStatusText(status_text, 1);
+	if ((this->scope_parameters->mode == 'a') || (this->scope_parameters->mode == 'd'))
+		sprintf(status_text, "%.0f waveforms/s%s", this->scope_parameters->engine_waveform_rate, sweep_status[(this->scope_parameters->engine_trigger_status < 4)? this->scope_parameters->engine_trigger_status : 0]);
+	else
+		sprintf(status_text, " ");
+	SetStatusText(status_text, 2);
+	// Ch1 frequency and duty cycle, ch2 phase with respect to ch1.
+	const double* m = this->scope_parameters->engine_measurements;
+	if ((this->scope_parameters->mode == 'a') && this->scope_parameters->engine_measured)
+		sprintf(status_text, "Ch1 %.4g Hz, %.1f%%; ch2 %+.1f deg", m[0], m[1], m[6]);
+	else
+		sprintf(status_text, " ");
+	SetStatusText(status_text, 3);
 	return;
 }
 
+// Shows as many trigger channels as the engine captures; the second
+// vertical-scale panel controls any channel but the first one, chosen
+// from a list that is only shown when there are more than two channels.
+void GuiFrame::rebuildChannels()
+{
+	unsigned int nr_channels = this->scope_parameters->nr_channels;
+
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++)
+		this->radiobox_trig_chan->Show(c, c < nr_channels);
+	if (this->scope_parameters->trig_channel >= nr_channels) {
+		this->scope_parameters->trig_channel = 0;
+		this->radiobox_trig_chan->SetSelection(0);
+		this->setSpinnerTrigLevelExtrema();
+	}
+
+	this->choice_second_channel->Clear();
+	for (unsigned int c = 1; c < nr_channels; c++)
+		this->choice_second_channel->Append(wxString::Format("%u", c + 1));
+	this->choice_second_channel->SetSelection(0);
+	this->choice_second_channel->Show(nr_channels > 2);
+	this->statictext_title_y2dv->SetLabel((nr_channels > 2)? wxT("Vertical scale, channel") : wxT("Vertical scale, channel 2"));
+	wxCommandEvent ev(wxEVT_CHOICE, EVENT_CHOICE_SECOND_CHANNEL);
+	this->selectSecondChannel(ev);
+	this->Layout();
+	this->scope_parameters->send_changes = true;
+
+	return;
+}
+
+void GuiFrame::rebuildTimebase()
+{
+	std::string	previous_tdiv = this->scope_parameters->list_tdiv[this->scope_parameters->tdiv_idx];
+	std::vector<std::string>	list_tdiv;
+	std::vector<std::string>	list_tdiv_txt;
+	const int	mantissas[3] = {1, 2, 5};
+	char		text[32];
+
+	for (int e = -6; e <= 0; e++) {
+		for (int m = 0; m < 3; m++) {
+			double value = mantissas[m] * pow(10.0, e);
+			if ((value * HORIZ_DIVS * this->scope_parameters->engine_sample_rate < MIN_SAMPLES_PER_TRACE) || (value > 5.0))
+				continue;
+			sprintf(text, "%de%+d", mantissas[m], e);
+			list_tdiv.push_back(text);
+			if (value < 1e-4)
+				sprintf(text, "%g us", value * 1e6);
+			else if (value < 1e-1)
+				sprintf(text, "%g ms", value * 1e3);
+			else
+				sprintf(text, "%g s", value);
+			list_tdiv_txt.push_back(text);
+		}
+	}
+
+	int ti = list_tdiv.size() - 1;
+	for (int i = 0; i < list_tdiv.size(); i++) {
+		if (list_tdiv[i] == previous_tdiv) {
+			ti = i;
+			break;
+		}
+	}
+	this->scope_parameters->list_tdiv = list_tdiv;
+	this->scope_parameters->list_tdiv_txt = list_tdiv_txt;
+	this->scope_parameters->tdiv_idx = ti;
+
+	this->button_tdiv_up->Enable();
+	this->button_tdiv_dw->Enable();
+	if (ti == list_tdiv.size() - 1)
+		this->button_tdiv_up->Disable();
+	if (ti == 0)
+		this->button_tdiv_dw->Disable();
+	this->updateTdiv();
+	this->scope_parameters->send_changes = true;
+	return;
+}
 
 void GuiFrame::selectFileToSave(wxCommandEvent& WXUNUSED(event))
 {
@@ -618,6 +1198,7 @@ void GuiFrame::toggleMode(wxCommandEvent& WXUNUSED(event))
 		this->spinner_trig_level->Disable();
 		this->statictext_label_trig->Disable();
 		this->choice_averages->Disable();
+		this->choice_average_mode->Disable();
 	} else if (this->scope_parameters->mode == 'x') {
 		this->button_togglemode->SetLabel("MODE: Digital");
 		this->scope_parameters->mode = 'd';
@@ -630,6 +1211,7 @@ void GuiFrame::toggleMode(wxCommandEvent& WXUNUSED(event))
 		this->spinner_trig_level->Disable();
 		this->statictext_label_trig->Disable();
 		this->choice_averages->Disable();
+		this->choice_average_mode->Disable();
 	} else if (this->scope_parameters->mode == 'd') {
 		this->button_togglemode->SetLabel("MODE: Voltmeter");
 		this->scope_parameters->mode = 'v';
@@ -642,7 +1224,47 @@ void GuiFrame::toggleMode(wxCommandEvent& WXUNUSED(event))
 		this->spinner_trig_level->Disable();
 		this->statictext_label_trig->Disable();
 		this->choice_averages->Disable();
+		this->choice_average_mode->Disable();
 	} else if (this->scope_parameters->mode == 'v') {
+		this->button_togglemode->SetLabel("MODE: Spectrum");
+		this->scope_parameters->mode = 'f';
+		this->button_y1dv_up->Enable();
+		this->button_y1dv_dw->Enable();
+		this->button_y2dv_up->Disable();
+		this->button_y2dv_dw->Disable();
+		this->statictext_value_y1dv->Show();
+		this->statictext_value_y2dv->Hide();
+		this->spinner_trig_level->Disable();
+		this->statictext_label_trig->Disable();
+		this->choice_averages->Enable();
+		this->choice_average_mode->Disable();
+	} else if (this->scope_parameters->mode == 'f') {
+		this->button_togglemode->SetLabel("MODE: Waterfall");
+		this->scope_parameters->mode = 'w';
+		this->button_y1dv_up->Disable();
+		this->button_y1dv_dw->Disable();
+		this->button_y2dv_up->Disable();
+		this->button_y2dv_dw->Disable();
+		this->statictext_value_y1dv->Hide();
+		this->statictext_value_y2dv->Hide();
+		this->spinner_trig_level->Disable();
+		this->statictext_label_trig->Disable();
+		this->choice_averages->Disable();
+		this->choice_average_mode->Disable();
+	} else if (this->scope_parameters->mode == 'w') {
+		this->button_togglemode->SetLabel("MODE: Bode");
+		this->scope_parameters->mode = 'b';
+		this->button_y1dv_up->Disable();
+		this->button_y1dv_dw->Disable();
+		this->button_y2dv_up->Disable();
+		this->button_y2dv_dw->Disable();
+		this->statictext_value_y1dv->Hide();
+		this->statictext_value_y2dv->Hide();
+		this->spinner_trig_level->Disable();
+		this->statictext_label_trig->Disable();
+		this->choice_averages->Disable();
+		this->choice_average_mode->Disable();
+	} else if (this->scope_parameters->mode == 'b') {
 		this->button_togglemode->SetLabel("MODE: Analog");
 		this->scope_parameters->mode = 'a';
 		this->button_y1dv_up->Enable();
@@ -654,7 +1276,32 @@ void GuiFrame::toggleMode(wxCommandEvent& WXUNUSED(event))
 		this->spinner_trig_level->Enable();
 		this->statictext_label_trig->Enable();
 		this->choice_averages->Enable();
+		this->choice_average_mode->Enable();
 	}
+	bool digital = (this->scope_parameters->mode == 'd');
+	this->statictext_label_logic->Enable(digital);
+	this->spinner_logic_window->Enable(digital);
+	this->spinner_logic_threshold->Enable(digital);
+	this->statictext_label_decoder->Enable(digital);
+	this->choice_decoder->Enable(digital);
+	this->spinner_decoder_baud->Enable(digital);
+	bool voltmeter = (this->scope_parameters->mode == 'v');
+	this->statictext_label_voltmeter->Enable(voltmeter);
+	this->spinner_voltmeter_interval->Enable(voltmeter);
+	this->checkbox_measure->Enable(this->scope_parameters->mode == 'a');
+	// The waterfall shares the window of spectrum mode, and shows the
+	// trigger channel.
+	bool spectrum = (this->scope_parameters->mode == 'f');
+	this->statictext_label_spectrum->Enable(spectrum || (this->scope_parameters->mode == 'w'));
+	this->choice_spectrum_window->Enable(spectrum || (this->scope_parameters->mode == 'w'));
+	this->choice_spectrum_scale->Enable(spectrum);
+	this->choice_spectrum_averaging->Enable(spectrum);
+	bool bode = (this->scope_parameters->mode == 'b');
+	this->statictext_label_bode->Enable(bode);
+	this->spinner_bode_start->Enable(bode);
+	this->spinner_bode_stop->Enable(bode);
+	this->spinner_bode_points->Enable(bode);
+	this->updateTrigType();
 	this->scope_parameters->change_mode = true;
 	return;
 }
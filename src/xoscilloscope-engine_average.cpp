@@ -0,0 +1,130 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <cmath>
+#include <algorithm>
+
+#include "xoscilloscope-engine_average.h"
+
+void oXs_average_reset(WaveformAverage* average, average_mode mode, unsigned int nr_channels, unsigned int trace_size, unsigned int nr_of_averages)
+{
+	if (nr_of_averages < 1)
+		nr_of_averages = 1;
+	if ((mode == AVG_RUNNING) && ((unsigned long) nr_of_averages * trace_size * nr_channels > AVERAGE_MAX_SAMPLES))
+		mode = AVG_EXPONENTIAL;
+	average->mode = mode;
+	average->nr_channels = nr_channels;
+	average->trace_size = trace_size;
+	average->nr_of_averages = nr_of_averages;
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++) {
+		average->sum[c].assign((c < nr_channels)? trace_size : 0, 0.0);
+		if ((mode == AVG_RUNNING) && (c < nr_channels))
+			average->stored[c].assign((unsigned long) nr_of_averages * trace_size, 0.0);
+		else
+			std::vector<float>().swap(average->stored[c]);
+	}
+	average->count = 0;
+	average->slot = 0;
+
+	return;
+}
+
+// Forgets all waveforms, keeping the settings and the memory.
+void oXs_average_clear(WaveformAverage* average)
+{
+	for (unsigned int c = 0; c < average->nr_channels; c++) {
+		std::fill(average->sum[c].begin(), average->sum[c].end(), 0.0);
+		std::fill(average->stored[c].begin(), average->stored[c].end(), 0.0);
+	}
+	average->count = 0;
+	average->slot = 0;
+
+	return;
+}
+
+// Enters a waveform (as laid out by oXs_trace_buffer_copy_window, i.e. in
+// one piece), scaled by k and resampled so that its trigger instant, which
+// precedes the trigger sample by fraction, falls on a sample. In running
+// averages, the stored waveform being replaced has been zeroed while the
+// ring was filling up, so the same pass serves both cases.
+bool oXs_average_add(WaveformAverage* average, const TraceBuffer* waveform, const double* k, float fraction)
+{
+	unsigned int n = average->trace_size;
+	if (waveform->count != n)
+		return false;
+	unsigned int first = oXs_trace_buffer_index(waveform, 0);
+	for (unsigned int c = 0; c < average->nr_channels; c++) {
+		const float* x = waveform->samples[c] + first;
+		bool finite = true;
+		for (unsigned int j = 0; j < n; j++)
+			finite &= (x[j] == x[j]);
+		if (!finite)
+			return false;
+	}
+
+	if (average->count < average->nr_of_averages)
+		average->count++;
+	for (unsigned int c = 0; c < average->nr_channels; c++) {
+		const float* x = waveform->samples[c] + first;
+		double* s = average->sum[c].data();
+		float a = (1.0 - fraction) * k[c];
+		float b = fraction * k[c];
+		if (average->mode == AVG_RUNNING) {
+			float* old = average->stored[c].data() + (unsigned long) average->slot * n;
+			float v = (a + b) * x[0];
+			s[0] += (double) v - (double) old[0];
+			old[0] = v;
+			for (unsigned int j = 1; j < n; j++) {
+				v = a * x[j] + b * x[j - 1];
+				s[j] += (double) v - (double) old[j];
+				old[j] = v;
+			}
+		} else {
+			double w = 1.0 / average->count;
+			s[0] += ((a + b) * x[0] - s[0]) * w;
+			for (unsigned int j = 1; j < n; j++)
+				s[j] += ((double) (a * x[j] + b * x[j - 1]) - s[j]) * w;
+		}
+	}
+	if (average->mode == AVG_RUNNING)
+		average->slot = (average->slot + 1 < average->nr_of_averages)? average->slot + 1 : 0;
+
+	return true;
+}
+
+// Adds the average of each channel to column c + 1 of the plot data.
+void oXs_average_fill(const WaveformAverage* average, std::vector< std::vector<double> > & gnuplot_data)
+{
+	if (average->count == 0)
+		return;
+	double w = (average->mode == AVG_RUNNING)? 1.0 / average->count : 1.0;
+	unsigned int nr_rows = std::min((unsigned int) gnuplot_data.size(), average->trace_size);
+	for (unsigned int c = 0; c < average->nr_channels; c++) {
+		const double* s = average->sum[c].data();
+		for (unsigned int j = 0; j < nr_rows; j++)
+			gnuplot_data[j][c + 1] += s[j] * w;
+	}
+
+	return;
+}
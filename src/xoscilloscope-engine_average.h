@@ -0,0 +1,66 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_AVERAGE_H
+#define XOSCILLOSCOPE_ENGINE_AVERAGE_H
+
+#include <vector>
+
+#include "xoscilloscope-engine_buffer.h"
+
+#define AVERAGE_MAX_SAMPLES (1 << 25)
+
+enum average_mode : unsigned int {
+	AVG_RUNNING,
+	AVG_EXPONENTIAL
+};
+
+// Average of the latest nr_of_averages triggered waveforms, kept up to date
+// one waveform at a time.
+//  - running: the sum of the stored waveforms is updated by adding the new
+//    waveform and subtracting the one it replaces in the ring of stored
+//    waveforms, in a single pass;
+//  - exponential: only the average itself is kept, each new waveform
+//    weighing 1/nr_of_averages (1/count while fewer waveforms have come).
+// Waveforms are stored as floats, sums as doubles. The ring of a running
+// average is bounded to AVERAGE_MAX_SAMPLES samples; beyond that, the
+// exponential average is used instead. Waveforms that are shorter than
+// trace_size, or that contain a gap, are not averaged.
+struct WaveformAverage {
+	average_mode		mode;
+	unsigned int		nr_channels;
+	unsigned int		trace_size;
+	unsigned int		nr_of_averages;
+	unsigned int		count;
+	unsigned int		slot;
+	std::vector<double>	sum[MAX_CHANNELS];
+	std::vector<float>	stored[MAX_CHANNELS];
+};
+
+void oXs_average_reset(WaveformAverage*, average_mode, unsigned int, unsigned int, unsigned int);
+void oXs_average_clear(WaveformAverage*);
+bool oXs_average_add(WaveformAverage*, const TraceBuffer*, const double*, float);
+void oXs_average_fill(const WaveformAverage*, std::vector< std::vector<double> > &);
+
+#endif
@@ -0,0 +1,285 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "xoscilloscope-engine_bode.h"
+
+void oXs_bode_init(BodeSweep* sweep)
+{
+	sweep->fifo = -1;
+	sweep->sample_rate = 0;
+	sweep->points.clear();
+	sweep->step = 0;
+
+	return;
+}
+
+// Writes one line to the generator. The pipe is opened on demand, without
+// blocking: when wavex is not listening the sweep waits, trying again
+// every second of samples.
+static bool oXs_bode_send(BodeSweep* sweep, double frequency)
+{
+	if (sweep->fifo < 0) {
+		sweep->fifo = open(BODE_FIFO, O_WRONLY | O_NONBLOCK);
+		if (sweep->fifo < 0)
+			return false;
+	}
+	char line[64];
+	int length = snprintf(line, sizeof(line), "b%.6f\n", frequency);
+	if (write(sweep->fifo, line, length) != length) {
+		close(sweep->fifo);
+		sweep->fifo = -1;
+		return false;
+	}
+
+	return true;
+}
+
+static void oXs_bode_clear_window(BodeSweep* sweep)
+{
+	sweep->filled = 0;
+	sweep->phasor_re = 1.0;
+	sweep->phasor_im = 0.0;
+	for (unsigned int c = 0; c < 2; c++) {
+		sweep->sum_re[c] = 0.0;
+		sweep->sum_im[c] = 0.0;
+	}
+	sweep->sum = 0.0;
+	sweep->sum_squares = 0.0;
+
+	return;
+}
+
+// Tells the generator the frequency of the current point, and sizes the
+// window to the whole number of cycles closest to the longest of
+// BODE_MIN_CYCLES cycles and BODE_MIN_SAMPLES samples.
+static void oXs_bode_start_point(BodeSweep* sweep)
+{
+	double frequency = sweep->points[sweep->step].frequency;
+	double samples_per_cycle = sweep->sample_rate / frequency;
+	double cycles = ceil(std::max((double) BODE_MIN_CYCLES, BODE_MIN_SAMPLES / samples_per_cycle));
+	sweep->window = (unsigned int) lround(cycles * samples_per_cycle);
+	double omega = 2.0 * M_PI * frequency / sweep->sample_rate;
+	sweep->rotation_re = cos(omega);
+	sweep->rotation_im = -sin(omega);
+	sweep->windows = 0;
+	sweep->waited = 0;
+	sweep->sent = oXs_bode_send(sweep, frequency);
+	sweep->retry = 0;
+	oXs_bode_clear_window(sweep);
+
+	return;
+}
+
+// Points are spaced logarithmically between start and stop; scale is the
+// ratio of the volts per unit of channel 2 to those of channel 1. The
+// measured points are kept when only the scale changes.
+void oXs_bode_reset(BodeSweep* sweep, unsigned int sample_rate, double start, double stop, unsigned int nr_points, double scale)
+{
+	if (nr_points < 2)
+		nr_points = 2;
+	if (nr_points > BODE_MAX_POINTS)
+		nr_points = BODE_MAX_POINTS;
+	if (stop > 0.45 * sample_rate)
+		stop = 0.45 * sample_rate;
+	if (start < 1.0)
+		start = 1.0;
+	if (start >= stop)
+		start = stop / 10.0;
+
+	bool same_sweep = (sweep->sample_rate == sample_rate) && (sweep->points.size() == nr_points)
+		&& (sweep->points[0].frequency == start) && (sweep->points[nr_points - 1].frequency == stop);
+	if (!same_sweep) {
+		sweep->points.resize(nr_points);
+		for (unsigned int k = 0; k < nr_points; k++) {
+			sweep->points[k].frequency = (k == nr_points - 1)? stop : start * pow(stop / start, (double) k / (nr_points - 1));
+			sweep->points[k].gain = 0.0;
+			sweep->points[k].phase = 0.0;
+			sweep->points[k].valid = false;
+		}
+	}
+	sweep->sample_rate = sample_rate;
+	sweep->scale = scale;
+	sweep->step = 0;
+	oXs_bode_start_point(sweep);
+
+	return;
+}
+
+static void oXs_bode_next_point(BodeSweep* sweep)
+{
+	sweep->step = (sweep->step + 1) % sweep->points.size();
+	oXs_bode_start_point(sweep);
+
+	return;
+}
+
+// Called when a window is complete. Returns true when the point is taken
+// (or given up).
+static bool oXs_bode_close_window(BodeSweep* sweep)
+{
+	unsigned int n = sweep->window;
+	double mean = sweep->sum / n;
+	double variance = sweep->sum_squares / n - mean * mean;
+	double power_1 = sweep->sum_re[0] * sweep->sum_re[0] + sweep->sum_im[0] * sweep->sum_im[0];
+	double power_2 = sweep->sum_re[1] * sweep->sum_re[1] + sweep->sum_im[1] * sweep->sum_im[1];
+	double tone = 2.0 * power_1 / ((double) n * n);
+	sweep->waited += n;
+
+	BodePoint* point = &sweep->points[sweep->step];
+	if ((variance <= 0.0) || (tone < BODE_TONE_FRACTION * variance)) {
+		sweep->windows = 0;
+		if (sweep->waited > BODE_TIMEOUT * sweep->sample_rate) {
+			point->valid = false;
+			oXs_bode_next_point(sweep);
+			return true;
+		}
+		oXs_bode_clear_window(sweep);
+		return false;
+	}
+
+	// H = X2 / X1, so that a delay of channel 2 gives a negative phase.
+	double h_re = (sweep->sum_re[1] * sweep->sum_re[0] + sweep->sum_im[1] * sweep->sum_im[0]) / power_1;
+	double h_im = (sweep->sum_im[1] * sweep->sum_re[0] - sweep->sum_re[1] * sweep->sum_im[0]) / power_1;
+	double gain = sqrt(power_2 / power_1) * sweep->scale;
+	double phase = atan2(h_im, h_re) * 180.0 / M_PI;
+	double phase_change = fabs(phase - sweep->last_phase);
+	if (phase_change > 180.0)
+		phase_change = 360.0 - phase_change;
+	bool settled = (sweep->windows > 0) && (fabs(gain - sweep->last_gain) <= BODE_GAIN_TOLERANCE * sweep->last_gain)
+		&& (phase_change <= BODE_PHASE_TOLERANCE);
+	sweep->windows++;
+	sweep->last_gain = gain;
+	sweep->last_phase = phase;
+	if (settled || (sweep->windows >= BODE_MAX_WINDOWS)) {
+		point->gain = 20.0 * log10(std::max(gain, 1e-15));
+		point->phase = phase;
+		point->valid = true;
+		oXs_bode_next_point(sweep);
+		return true;
+	}
+	oXs_bode_clear_window(sweep);
+
+	return false;
+}
+
+// Runs the samples of channels 1 and 2 through the detector. Lost frames
+// break the window in progress, which is started again. Returns true when
+// at least one point has been taken.
+bool oXs_bode_push_period(BodeSweep* sweep, const PeriodBlock* block)
+{
+	if (sweep->points.empty())
+		return false;
+	if (!sweep->sent) {
+		sweep->retry += block->size;
+		if (sweep->retry < sweep->sample_rate)
+			return false;
+		sweep->retry = 0;
+		sweep->sent = oXs_bode_send(sweep, sweep->points[sweep->step].frequency);
+		return false;
+	}
+	if (block->gap_frames > 0) {
+		sweep->windows = 0;
+		oXs_bode_clear_window(sweep);
+	}
+
+	bool taken = false;
+	const float* x1 = block->samples[0];
+	const float* x2 = block->samples[1];
+	for (unsigned int j = 0; j < block->size; j++) {
+		double p_re = sweep->phasor_re, p_im = sweep->phasor_im;
+		sweep->sum_re[0] += x1[j] * p_re;
+		sweep->sum_im[0] += x1[j] * p_im;
+		sweep->sum_re[1] += x2[j] * p_re;
+		sweep->sum_im[1] += x2[j] * p_im;
+		sweep->sum += x1[j];
+		sweep->sum_squares += (double) x1[j] * x1[j];
+		sweep->phasor_re = p_re * sweep->rotation_re - p_im * sweep->rotation_im;
+		sweep->phasor_im = p_re * sweep->rotation_im + p_im * sweep->rotation_re;
+		if ((++sweep->filled & 1023) == 0) {
+			double norm = sqrt(sweep->phasor_re * sweep->phasor_re + sweep->phasor_im * sweep->phasor_im);
+			sweep->phasor_re /= norm;
+			sweep->phasor_im /= norm;
+		}
+		if (sweep->filled == sweep->window) {
+			if (oXs_bode_close_window(sweep))
+				taken = true;
+			if (!sweep->sent)
+				break;
+		}
+	}
+
+	return taken;
+}
+
+// Gives the generator back to its own settings.
+void oXs_bode_stop(BodeSweep* sweep)
+{
+	if (sweep->fifo >= 0) {
+		oXs_bode_send(sweep, 0.0);
+		close(sweep->fifo);
+		sweep->fifo = -1;
+	}
+	sweep->points.clear();
+
+	return;
+}
+
+// One row per point: frequency, gain (dB) and phase (degrees); points not
+// measured yet are left undefined.
+void oXs_bode_fill(const BodeSweep* sweep, std::vector< std::vector<double> > & gnuplot_data)
+{
+	unsigned int nr_points = sweep->points.size();
+	if ((gnuplot_data.size() != nr_points) || (nr_points && (gnuplot_data[0].size() != 3)))
+		gnuplot_data.assign(nr_points, std::vector<double>(3, 0.0));
+	for (unsigned int k = 0; k < nr_points; k++) {
+		const BodePoint* point = &sweep->points[k];
+		gnuplot_data[k][0] = point->frequency;
+		gnuplot_data[k][1] = point->valid? point->gain : NAN;
+		gnuplot_data[k][2] = point->valid? point->phase : NAN;
+	}
+
+	return;
+}
+
+void oXs_bode_labels(const BodeSweep* sweep, std::vector<std::string> & labels)
+{
+	char label[160];
+	labels.clear();
+	if (sweep->points.empty())
+		return;
+	if (!sweep->sent)
+		snprintf(label, sizeof(label), "label 1 \"Waiting for wavex (%s)\" at graph 0.02, graph 0.95 left front tc rgb \"yellow\"", BODE_FIFO);
+	else
+		snprintf(label, sizeof(label), "label 1 \"Point %u/%u: %.1f Hz\" at graph 0.02, graph 0.95 left front tc rgb \"yellow\"",
+			sweep->step + 1, (unsigned int) sweep->points.size(), sweep->points[sweep->step].frequency);
+	labels.push_back(label);
+
+	return;
+}
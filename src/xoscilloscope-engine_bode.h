@@ -0,0 +1,101 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_BODE_H
+#define XOSCILLOSCOPE_ENGINE_BODE_H
+
+#include <vector>
+#include <string>
+
+#include "xoscilloscope-engine_buffer.h"
+
+// Named pipe through which the generator (wavex) is told the frequency of
+// each point, one line "b<frequency in Hz>" per point, "b0" to give the
+// generator back to its own settings. Both programs must run in the same
+// directory.
+#define BODE_FIFO "wavex.fifo"
+#define BODE_DEFAULT_START 20.0
+#define BODE_DEFAULT_STOP 20000.0
+#define BODE_DEFAULT_POINTS 40
+#define BODE_MAX_POINTS 1000
+#define BODE_MIN_CYCLES 8
+#define BODE_MIN_SAMPLES 1024
+#define BODE_MAX_WINDOWS 16
+#define BODE_TONE_FRACTION 0.8
+#define BODE_GAIN_TOLERANCE 0.005
+#define BODE_PHASE_TOLERANCE 0.5
+#define BODE_TIMEOUT 3.0
+
+struct BodePoint {
+	double	frequency;
+	double	gain;
+	double	phase;
+	bool	valid;
+};
+
+// Swept-frequency response of channel 2 with respect to channel 1 (the
+// input of the circuit under test). For each point, the generator is set
+// to the point frequency, and the captured stream is cut into windows of a
+// whole number of cycles (at least BODE_MIN_CYCLES and BODE_MIN_SAMPLES),
+// in which the component of both channels at that frequency is taken by a
+// single-bin DFT, the rotating phasor being shared by the two channels.
+// Windows are discarded until the tone has reached channel 1, i.e. until
+// it carries at least BODE_TONE_FRACTION of the AC power of the channel;
+// the point is taken as soon as two consecutive windows agree within the
+// tolerances, and at the latest after BODE_MAX_WINDOWS windows. Points
+// whose tone has not shown up within BODE_TIMEOUT are skipped. The sweep
+// starts over after the last point, each point being replaced when it is
+// measured again.
+struct BodeSweep {
+	int			fifo;
+	unsigned int		sample_rate;
+	double			scale;
+	std::vector<BodePoint>	points;
+	unsigned int		step;
+	unsigned int		window;
+	unsigned int		filled;
+	unsigned int		windows;
+	unsigned long		waited;
+	unsigned long		retry;
+	bool			sent;
+	double			phasor_re;
+	double			phasor_im;
+	double			rotation_re;
+	double			rotation_im;
+	double			sum_re[2];
+	double			sum_im[2];
+	double			sum;
+	double			sum_squares;
+	double			last_gain;
+	double			last_phase;
+};
+
+void oXs_bode_init(BodeSweep*);
+void oXs_bode_reset(BodeSweep*, unsigned int, double, double, unsigned int, double);
+bool oXs_bode_push_period(BodeSweep*, const PeriodBlock*);
+void oXs_bode_stop(BodeSweep*);
+void oXs_bode_fill(const BodeSweep*, std::vector< std::vector<double> > &);
+void oXs_bode_labels(const BodeSweep*, std::vector<std::string> &);
+
+#endif
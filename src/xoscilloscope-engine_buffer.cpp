@@ -0,0 +1,165 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <iostream>
+#include <cstring>
+
+#include "xoscilloscope-engine_buffer.h"
+
+void oXs_trace_buffer_init(TraceBuffer* tb, unsigned int nr_channels)
+{
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++)
+		tb->samples[c] = NULL;
+	tb->nr_channels = nr_channels;
+	tb->capacity = 0;
+	tb->head = 0;
+	tb->count = 0;
+
+	return;
+}
+
+void oXs_trace_buffer_reserve(TraceBuffer* tb, unsigned int capacity)
+{
+	if (capacity < 1)
+		capacity = 1;
+	if (capacity == tb->capacity)
+		return;
+
+	free(tb->samples[0]);
+	float* block = (float *) malloc(sizeof(float) * capacity * tb->nr_channels);
+	if (block == NULL) {
+		std::cerr << "Could not allocate trace buffer... exiting.\n";
+		exit(1);
+	}
+	for (unsigned int c = 0; c < tb->nr_channels; c++)
+		tb->samples[c] = block + c * capacity;
+	tb->capacity = capacity;
+	tb->head = 0;
+	tb->count = 0;
+
+	return;
+}
+
+void oXs_trace_buffer_free(TraceBuffer* tb)
+{
+	free(tb->samples[0]);
+	oXs_trace_buffer_init(tb, tb->nr_channels);
+
+	return;
+}
+
+// Replaces the content of dst with the nr_samples samples of src that end
+// offset samples before the most recent one (fewer, if src holds fewer).
+void oXs_trace_buffer_copy_window(TraceBuffer* dst, const TraceBuffer* src, unsigned int nr_samples, unsigned int offset)
+{
+	if (offset > src->count)
+		offset = src->count;
+	if (nr_samples > src->count - offset)
+		nr_samples = src->count - offset;
+	if (nr_samples > dst->capacity)
+		nr_samples = dst->capacity;
+
+	unsigned int first = oXs_trace_buffer_index(src, src->count - offset - nr_samples);
+	unsigned int head_part = (first + nr_samples > src->capacity)? src->capacity - first : nr_samples;
+	for (unsigned int c = 0; c < dst->nr_channels; c++) {
+		memcpy(dst->samples[c], src->samples[c] + first, sizeof(float) * head_part);
+		memcpy(dst->samples[c] + head_part, src->samples[c], sizeof(float) * (nr_samples - head_part));
+	}
+	dst->count = nr_samples;
+	dst->head = (nr_samples == dst->capacity)? 0 : nr_samples;
+
+	return;
+}
+
+// Appends a whole period, channel by channel.
+void oXs_trace_buffer_push_period(TraceBuffer* tb, const PeriodBlock* block)
+{
+	unsigned int n = block->size, skip = 0;
+	if (n > tb->capacity) {
+		skip = n - tb->capacity;
+		n = tb->capacity;
+	}
+	unsigned int head_part = (tb->head + n > tb->capacity)? tb->capacity - tb->head : n;
+	for (unsigned int c = 0; c < tb->nr_channels; c++) {
+		const float* x = block->samples[c] + skip;
+		memcpy(tb->samples[c] + tb->head, x, sizeof(float) * head_part);
+		memcpy(tb->samples[c], x + head_part, sizeof(float) * (n - head_part));
+	}
+	tb->head = (tb->head + n) % tb->capacity;
+	tb->count = (tb->count + n > tb->capacity)? tb->capacity : tb->count + n;
+
+	return;
+}
+
+void oXs_period_block_allocate(PeriodBlock* block, unsigned int size, unsigned int nr_channels)
+{
+	float* data = (float *) malloc(sizeof(float) * size * nr_channels);
+	if (data == NULL) {
+		std::cerr << "Could not allocate period buffer... exiting.\n";
+		exit(1);
+	}
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++)
+		block->samples[c] = (c < nr_channels)? data + c * size : NULL;
+	block->storage = data;
+	block->nr_channels = nr_channels;
+	block->size = 0;
+	block->gap_frames = 0;
+
+	return;
+}
+
+void oXs_period_block_free(PeriodBlock* block)
+{
+	free(block->storage);
+	block->storage = NULL;
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++)
+		block->samples[c] = NULL;
+	block->size = 0;
+
+	return;
+}
+
+void oXs_frame_ring_allocate(FrameRing* ring, unsigned int capacity, unsigned int frame_bytes)
+{
+	ring->frames = (unsigned char *) malloc((size_t) capacity * frame_bytes);
+	if (ring->frames == NULL) {
+		std::cerr << "Could not allocate capture ring... exiting.\n";
+		exit(1);
+	}
+	ring->frame_bytes = frame_bytes;
+	ring->capacity = capacity;
+	ring->write_count.store(0);
+	ring->read_count.store(0);
+
+	return;
+}
+
+void oXs_frame_ring_free(FrameRing* ring)
+{
+	free(ring->frames);
+	ring->frames = NULL;
+	ring->capacity = 0;
+
+	return;
+}
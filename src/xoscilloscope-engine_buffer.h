@@ -0,0 +1,175 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_BUFFER_H
+#define XOSCILLOSCOPE_ENGINE_BUFFER_H
+
+#include <cstdlib>
+#include <cstdint>
+#include <cmath>
+#include <atomic>
+
+#define MAX_CHANNELS 8
+
+// Fixed-capacity ring of samples for nr_channels channels, stored channel by
+// channel (one contiguous array per channel). Samples are expressed in units
+// of a 16-bit converter (see xoscilloscope-engine_format.h). Memory is only
+// (re)allocated when the requested capacity changes, i.e. when the time
+// scale is modified.
+struct TraceBuffer {
+	float*		samples[MAX_CHANNELS];
+	unsigned int	nr_channels;
+	unsigned int	capacity;
+	unsigned int	head;
+	unsigned int	count;
+};
+
+void oXs_trace_buffer_init(TraceBuffer*, unsigned int);
+void oXs_trace_buffer_reserve(TraceBuffer*, unsigned int);
+void oXs_trace_buffer_free(TraceBuffer*);
+void oXs_trace_buffer_copy_window(TraceBuffer*, const TraceBuffer*, unsigned int, unsigned int);
+
+inline void oXs_trace_buffer_clear(TraceBuffer* tb)
+{
+	tb->head = 0;
+	tb->count = 0;
+}
+
+// One period of converted samples, deinterleaved channel by channel.
+// gap_frames counts the frames lost right before the period (device
+// overruns or capture ring overruns); it is zero for contiguous data.
+// samples may point into memory the block does not own (a period of the
+// capture ring, with mmap access); storage is what the block allocated.
+struct PeriodBlock {
+	float*		samples[MAX_CHANNELS];
+	float*		storage;
+	unsigned int	nr_channels;
+	unsigned int	size;
+	unsigned long	gap_frames;
+};
+
+void oXs_period_block_allocate(PeriodBlock*, unsigned int, unsigned int);
+void oXs_period_block_free(PeriodBlock*);
+void oXs_trace_buffer_push_period(TraceBuffer*, const PeriodBlock*);
+
+inline void oXs_trace_buffer_advance(TraceBuffer* tb)
+{
+	if (++tb->head == tb->capacity)
+		tb->head = 0;
+	if (tb->count < tb->capacity)
+		tb->count++;
+}
+
+inline void oXs_trace_buffer_push(TraceBuffer* tb, const float* frame)
+{
+	for (unsigned int c = 0; c < tb->nr_channels; c++)
+		tb->samples[c][tb->head] = frame[c];
+	oXs_trace_buffer_advance(tb);
+}
+
+inline void oXs_trace_buffer_push_block(TraceBuffer* tb, const PeriodBlock* block, unsigned int j)
+{
+	for (unsigned int c = 0; c < tb->nr_channels; c++)
+		tb->samples[c][tb->head] = block->samples[c][j];
+	oXs_trace_buffer_advance(tb);
+}
+
+// Marks a discontinuity with a frame of NaN samples: gnuplot breaks the
+// traces there, and no trigger condition can be met across it.
+inline void oXs_trace_buffer_push_gap(TraceBuffer* tb)
+{
+	for (unsigned int c = 0; c < tb->nr_channels; c++)
+		tb->samples[c][tb->head] = NAN;
+	oXs_trace_buffer_advance(tb);
+}
+
+inline void oXs_trace_buffer_pop_front(TraceBuffer* tb)
+{
+	if (tb->count > 0)
+		tb->count--;
+}
+
+inline unsigned int oXs_trace_buffer_index(const TraceBuffer* tb, unsigned int i)
+{
+	unsigned int k = tb->head + tb->capacity - tb->count + i;
+	return (k >= tb->capacity)? k - tb->capacity : k;
+}
+
+inline float oXs_trace_buffer_at(const TraceBuffer* tb, unsigned int chan, unsigned int i)
+{
+	return tb->samples[chan][oXs_trace_buffer_index(tb, i)];
+}
+
+inline float oXs_trace_buffer_back(const TraceBuffer* tb, unsigned int chan)
+{
+	return tb->samples[chan][(tb->head == 0)? tb->capacity - 1 : tb->head - 1];
+}
+
+// Single-producer/single-consumer ring of interleaved frames, used to hand
+// periods over from the capture thread to the processing loop. Frames are
+// kept in the native format of the source, frame_bytes bytes each. The two
+// counters only grow; the producer owns write_count, the consumer owns
+// read_count, and no lock is ever taken on the data path. Data are always
+// committed and released in whole periods, and the capacity is a multiple
+// of the period, so a period is contiguous in memory and can be processed
+// in place.
+struct FrameRing {
+	unsigned char*	frames;
+	unsigned int	frame_bytes;
+	unsigned int	capacity;
+	alignas(64) std::atomic<unsigned long>	write_count;
+	alignas(64) std::atomic<unsigned long>	read_count;
+};
+
+void oXs_frame_ring_allocate(FrameRing*, unsigned int, unsigned int);
+void oXs_frame_ring_free(FrameRing*);
+
+inline unsigned long oXs_frame_ring_fill(const FrameRing* ring)
+{
+	return ring->write_count.load(std::memory_order_acquire) - ring->read_count.load(std::memory_order_acquire);
+}
+
+inline unsigned char* oXs_frame_ring_write_pointer(FrameRing* ring)
+{
+	unsigned long w = ring->write_count.load(std::memory_order_relaxed);
+	return ring->frames + (w % ring->capacity) * ring->frame_bytes;
+}
+
+inline void oXs_frame_ring_commit(FrameRing* ring, unsigned int nr_frames)
+{
+	ring->write_count.fetch_add(nr_frames, std::memory_order_release);
+}
+
+inline const unsigned char* oXs_frame_ring_read_pointer(const FrameRing* ring)
+{
+	unsigned long r = ring->read_count.load(std::memory_order_relaxed);
+	return ring->frames + (r % ring->capacity) * ring->frame_bytes;
+}
+
+inline void oXs_frame_ring_release(FrameRing* ring, unsigned int nr_frames)
+{
+	ring->read_count.fetch_add(nr_frames, std::memory_order_release);
+}
+
+#endif
@@ -0,0 +1,210 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <pthread.h>
+#include <sched.h>
+
+#include "xoscilloscope-engine_capture.h"
+
+static inline unsigned int oXs_capture_slot(const CaptureThread* capture, unsigned long count)
+{
+	return (count / capture->period_size) % CAPTURE_RING_PERIODS;
+}
+
+// Points the block at one float period of the ring (mapped sources).
+static void oXs_capture_slot_view(const CaptureThread* capture, const unsigned char* slot, PeriodBlock* view)
+{
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++)
+		view->samples[c] = (c < capture->nr_channels)? (float *) slot + c * capture->period_size : NULL;
+	view->nr_channels = capture->nr_channels;
+
+	return;
+}
+
+static void oXs_capture_loop(CaptureThread* capture)
+{
+	FrameRing* ring = &(capture->ring);
+	unsigned char* scratch = (unsigned char *) malloc((size_t) capture->period_size * ring->frame_bytes);
+	PeriodBlock view;
+	view.storage = NULL;
+	unsigned long pending_gap = 0;
+	bool recovered = false;
+	std::chrono::steady_clock::time_point last_period = std::chrono::steady_clock::now();
+
+	while (capture->running.load(std::memory_order_relaxed)) {
+		unsigned long fill = oXs_frame_ring_fill(ring);
+		bool ring_full = (fill + capture->period_size > ring->capacity);
+		if (ring_full && !capture->source->isLive()) {
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			continue;
+		}
+		unsigned char* dest = (ring_full)? scratch : oXs_frame_ring_write_pointer(ring);
+
+		snd_pcm_sframes_t nr_read;
+		if (capture->mapped) {
+			oXs_capture_slot_view(capture, dest, &view);
+			nr_read = capture->source->convertPeriod(capture->deinterleave, &view);
+		} else {
+			nr_read = capture->source->readPeriod(dest);
+		}
+		if (nr_read < 0) {
+			int err = capture->source->recover(nr_read);
+			if (err < 0) {
+				capture->error.store(err);
+				capture->running.store(false);
+				break;
+			}
+			capture->xruns.fetch_add(1, std::memory_order_relaxed);
+			recovered = true;
+			continue;
+		}
+		if (nr_read == 0)
+			continue;
+
+		// The device stopped at the overrun and its buffer was discarded
+		// by the recovery, so the loss is estimated from the time elapsed
+		// since the last complete period. At least one frame is counted,
+		// so that the gap is always marked.
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		if (recovered) {
+			double elapsed = std::chrono::duration<double>(now - last_period).count();
+			long lost = lround(elapsed * capture->source->sample_rate) - nr_read;
+			if (lost < 1)
+				lost = 1;
+			capture->lost_frames.fetch_add(lost, std::memory_order_relaxed);
+			pending_gap += lost;
+			recovered = false;
+		}
+		last_period = now;
+
+		if (ring_full) {
+			capture->overruns.fetch_add(1, std::memory_order_relaxed);
+			capture->dropped_frames.fetch_add(nr_read, std::memory_order_relaxed);
+			pending_gap += nr_read;
+			continue;
+		}
+		capture->gap_frames[oXs_capture_slot(capture, ring->write_count.load(std::memory_order_relaxed))] = pending_gap;
+		pending_gap = 0;
+		oXs_frame_ring_commit(ring, nr_read);
+		fill += nr_read;
+		if (fill > capture->high_water.load(std::memory_order_relaxed))
+			capture->high_water.store(fill, std::memory_order_relaxed);
+
+		{
+			std::lock_guard<std::mutex> lock(capture->wakeup_mutex);
+		}
+		capture->wakeup.notify_one();
+	}
+
+	free(scratch);
+	return;
+}
+
+// nr_channels is the number of channels of the converted blocks, which may
+// exceed those of the source (see oXs_deinterleave).
+void oXs_capture_start(CaptureThread* capture, AcquisitionSource* source, unsigned int nr_channels)
+{
+	unsigned int period_size = source->period_size;
+	capture->source = source;
+	capture->period_size = period_size;
+	capture->nr_channels = nr_channels;
+	capture->mapped = source->isMapped();
+	capture->held = 0;
+	capture->deinterleave = oXs_select_deinterleave_kernel(source->format);
+	capture->error.store(0);
+	capture->xruns.store(0);
+	capture->lost_frames.store(0);
+	capture->overruns.store(0);
+	capture->dropped_frames.store(0);
+	capture->high_water.store(0);
+	unsigned int frame_bytes = (capture->mapped)? nr_channels * sizeof(float) : source->frameBytes();
+	oXs_frame_ring_allocate(&(capture->ring), period_size * CAPTURE_RING_PERIODS, frame_bytes);
+
+	capture->running.store(true);
+	capture->worker = std::thread(oXs_capture_loop, capture);
+
+	// Best effort: a real-time policy is only granted to privileged users.
+	struct sched_param param;
+	param.sched_priority = sched_get_priority_min(SCHED_FIFO);
+	pthread_setschedparam(capture->worker.native_handle(), SCHED_FIFO, &param);
+
+	return;
+}
+
+void oXs_capture_stop(CaptureThread* capture)
+{
+	capture->running.store(false);
+	if (capture->worker.joinable())
+		capture->worker.join();
+	oXs_frame_ring_free(&(capture->ring));
+
+	return;
+}
+
+// Waits for the next captured period and converts it, reading straight from
+// the ring, into the given block; the ring space is then handed back to the
+// capture thread. Periods of mapped sources are already converted: the
+// block is pointed at the period in the ring, which is held until the next
+// call. An unrecoverable source error is fatal.
+void oXs_capture_next_block(CaptureThread* capture, PeriodBlock* block)
+{
+	FrameRing* ring = &(capture->ring);
+	if (capture->held > 0) {
+		oXs_frame_ring_release(ring, capture->held);
+		capture->held = 0;
+	}
+	while (oXs_frame_ring_fill(ring) < capture->period_size) {
+		if (capture->error.load() < 0) {
+			std::cerr << "Capture error (" << snd_strerror(capture->error.load()) << ")... exiting.\n";
+			exit(1);
+		}
+		std::unique_lock<std::mutex> lock(capture->wakeup_mutex);
+		capture->wakeup.wait_for(lock, std::chrono::milliseconds(10), [capture, ring] { return oXs_frame_ring_fill(ring) >= capture->period_size; });
+	}
+	block->gap_frames = capture->gap_frames[oXs_capture_slot(capture, ring->read_count.load(std::memory_order_relaxed))];
+	if (capture->mapped) {
+		oXs_capture_slot_view(capture, oXs_frame_ring_read_pointer(ring), block);
+		block->size = capture->period_size;
+		capture->held = capture->period_size;
+		return;
+	}
+	capture->deinterleave(oXs_frame_ring_read_pointer(ring), block, capture->period_size, capture->source->nr_channels);
+	oXs_frame_ring_release(ring, capture->period_size);
+
+	return;
+}
+
+// Sleeps until a whole period is available in the ring, or until the
+// timeout (in seconds) expires; returns false on timeout. A capture error
+// also ends the wait, so that the next oXs_capture_next_block reports it.
+bool oXs_capture_wait(CaptureThread* capture, double timeout)
+{
+	FrameRing* ring = &(capture->ring);
+	std::unique_lock<std::mutex> lock(capture->wakeup_mutex);
+
+	return capture->wakeup.wait_for(lock, std::chrono::duration<double>(timeout), [capture, ring] { return (oXs_frame_ring_fill(ring) - capture->held >= capture->period_size) || (capture->error.load() < 0); });
+}
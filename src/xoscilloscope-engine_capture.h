@@ -0,0 +1,87 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_CAPTURE_H
+#define XOSCILLOSCOPE_ENGINE_CAPTURE_H
+
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "xoscilloscope-engine_buffer.h"
+#include "xoscilloscope-engine_source.h"
+#include "xoscilloscope-engine_format.h"
+
+#define CAPTURE_RING_PERIODS 128
+
+// The capture thread does nothing but drain the acquisition source into a
+// FrameRing, one period at a time. Sources write raw frames straight into
+// the ring (for ALSA, snd_pcm_readi), and the processing loop converts each
+// period straight out of the ring memory with the kernel matching the
+// source format. Mapped sources (ALSA with mmap access) are converted by
+// the capture thread instead, straight from the DMA area: the ring then
+// holds float periods, channel after channel, and the processing loop is
+// handed a block pointing into the ring, the period being held until the
+// next call (held frames are not counted as available). Counters may be
+// read at any time from the processing loop: xruns and lost_frames account
+// for device overruns (the engine did not read the sound card in time),
+// overruns and dropped_frames for capture ring overruns (the processing
+// loop did not keep up with the capture thread). Whatever the cause, the
+// number of frames missing before each committed period is stored in
+// gap_frames, one slot per ring period, and passed on with the converted
+// block.
+struct CaptureThread {
+	AcquisitionSource*	source;
+	unsigned int		period_size;
+	unsigned int		nr_channels;
+	bool			mapped;
+	unsigned int		held;
+	DeinterleaveKernel	deinterleave;
+	FrameRing		ring;
+	std::thread		worker;
+	std::atomic<bool>	running;
+	std::mutex		wakeup_mutex;
+	std::condition_variable	wakeup;
+	unsigned long		gap_frames[CAPTURE_RING_PERIODS];
+	std::atomic<int>	error;
+
+	std::atomic<unsigned long>	xruns;
+	std::atomic<unsigned long>	lost_frames;
+	std::atomic<unsigned long>	overruns;
+	std::atomic<unsigned long>	dropped_frames;
+	std::atomic<unsigned long>	high_water;
+};
+
+void oXs_capture_start(CaptureThread*, AcquisitionSource*, unsigned int);
+void oXs_capture_stop(CaptureThread*);
+void oXs_capture_next_block(CaptureThread*, PeriodBlock*);
+bool oXs_capture_wait(CaptureThread*, double);
+
+inline unsigned long oXs_capture_available(const CaptureThread* capture)
+{
+	return oXs_frame_ring_fill(&(capture->ring)) - capture->held;
+}
+
+#endif
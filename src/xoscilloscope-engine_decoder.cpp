@@ -0,0 +1,232 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <cmath>
+
+#include "xoscilloscope-engine_decoder.h"
+
+void oXs_decoder_init(ProtocolDecoder* decoder, FILE* output)
+{
+	decoder->output = output;
+	decoder->unflushed = false;
+	oXs_decoder_reset(decoder, DEC_NONE, 0, 2, 1.0, 0);
+
+	return;
+}
+
+void oXs_decoder_reset(ProtocolDecoder* decoder, decoder_type type, unsigned int channel, unsigned int nr_channels, double bit_samples, unsigned long span)
+{
+	decoder->type = type;
+	decoder->nr_channels = nr_channels;
+	decoder->channel = (channel < nr_channels)? channel : 0;
+	decoder->bit_samples = (bit_samples > 2.0)? bit_samples : 2.0;
+	decoder->span = span;
+	decoder->position = 0;
+	decoder->active = false;
+	decoder->previous[0] = decoder->previous[1] = LOGIC_UNKNOWN;
+	decoder->symbols.resize(DECODER_MAX_SYMBOLS);
+	decoder->symbol_head = 0;
+	decoder->nr_symbols = 0;
+
+	return;
+}
+
+static inline void oXs_decoder_drop(ProtocolDecoder* decoder)
+{
+	decoder->symbol_head = (decoder->symbol_head + 1) & (DECODER_MAX_SYMBOLS - 1);
+	decoder->nr_symbols--;
+}
+
+static void oXs_decoder_emit(ProtocolDecoder* decoder, unsigned long start, unsigned long end, char kind, unsigned char value, bool ack)
+{
+	if (decoder->nr_symbols == DECODER_MAX_SYMBOLS)
+		oXs_decoder_drop(decoder);
+	DecodedSymbol& symbol = decoder->symbols[(decoder->symbol_head + decoder->nr_symbols) & (DECODER_MAX_SYMBOLS - 1)];
+	symbol.start = start;
+	symbol.end = end;
+	symbol.kind = kind;
+	symbol.value = value;
+	symbol.ack = ack;
+	decoder->nr_symbols++;
+	if ((kind == 'D') && (decoder->output != NULL)) {
+		fputc(value, decoder->output);
+		decoder->unflushed = true;
+	}
+
+	return;
+}
+
+static void oXs_decoder_uart_step(ProtocolDecoder* decoder, unsigned long p, unsigned char level)
+{
+	if (!decoder->active) {
+		if ((decoder->previous[0] == 1) && (level == 0)) {
+			decoder->active = true;
+			decoder->start = p;
+			decoder->next_bit = p + 0.5 * decoder->bit_samples;
+			decoder->nr_bits = 0;
+			decoder->bits = 0;
+		}
+	} else if (p >= decoder->next_bit) {
+		if (decoder->nr_bits == 0) {
+			// A start bit that does not last is a glitch.
+			decoder->active = (level == 0);
+		} else if (decoder->nr_bits <= 8) {
+			decoder->bits |= level << (decoder->nr_bits - 1);
+		} else {
+			unsigned long end = decoder->start + lround(10.0 * decoder->bit_samples);
+			oXs_decoder_emit(decoder, decoder->start, end, (level == 1)? 'D' : 'E', decoder->bits, false);
+			decoder->active = false;
+		}
+		decoder->nr_bits++;
+		decoder->next_bit += decoder->bit_samples;
+	}
+	decoder->previous[0] = level;
+
+	return;
+}
+
+static void oXs_decoder_i2c_step(ProtocolDecoder* decoder, unsigned long p, unsigned char scl, unsigned char sda)
+{
+	if ((scl == 1) && (decoder->previous[0] == 1) && (sda != decoder->previous[1]) && (decoder->previous[1] != LOGIC_UNKNOWN)) {
+		if (sda == 0) {
+			oXs_decoder_emit(decoder, p, p, 'S', 0, false);
+			decoder->active = true;
+			decoder->nr_bits = 0;
+			decoder->bits = 0;
+		} else {
+			oXs_decoder_emit(decoder, p, p, 'P', 0, false);
+			decoder->active = false;
+		}
+	} else if (decoder->active && (scl == 1) && (decoder->previous[0] == 0)) {
+		if (decoder->nr_bits == 0)
+			decoder->start = p;
+		if (decoder->nr_bits < 8) {
+			decoder->bits = (decoder->bits << 1) | sda;
+			decoder->nr_bits++;
+		} else {
+			oXs_decoder_emit(decoder, decoder->start, p, 'D', decoder->bits, (sda == 0));
+			decoder->nr_bits = 0;
+			decoder->bits = 0;
+		}
+	}
+	decoder->previous[0] = scl;
+	decoder->previous[1] = sda;
+
+	return;
+}
+
+static void oXs_decoder_pulse_step(ProtocolDecoder* decoder, unsigned long p, unsigned char level)
+{
+	unsigned char previous = decoder->previous[0];
+	if ((previous == 0) && (level == 1)) {
+		if (decoder->active && (p - decoder->edge > 4.0 * decoder->bit_samples))
+			decoder->active = false;
+		if (!decoder->active) {
+			decoder->active = true;
+			decoder->start = p;
+			decoder->nr_bits = 0;
+			decoder->bits = 0;
+		}
+		decoder->edge = p;
+	} else if ((previous == 1) && (level == 0) && decoder->active) {
+		decoder->bits = (decoder->bits << 1) | ((p - decoder->edge > 1.5 * decoder->bit_samples)? 1 : 0);
+		decoder->edge = p;
+		if (++decoder->nr_bits == 8) {
+			oXs_decoder_emit(decoder, decoder->start, p, 'D', decoder->bits, false);
+			decoder->active = false;
+		}
+	}
+	decoder->previous[0] = level;
+
+	return;
+}
+
+// Feeds a period of logic levels (see oXs_logic_detector_process); a gap
+// preceding it takes one position, as in the logic trace.
+void oXs_decoder_push_period(ProtocolDecoder* decoder, const PeriodBlock* levels)
+{
+	if (decoder->type == DEC_NONE)
+		return;
+	if (levels->gap_frames > 0) {
+		decoder->active = false;
+		decoder->previous[0] = decoder->previous[1] = LOGIC_UNKNOWN;
+		decoder->position++;
+	}
+	const float* x = levels->samples[(decoder->type == DEC_I2C)? 0 : decoder->channel];
+	const float* y = levels->samples[1];
+	unsigned long p = decoder->position;
+	if (decoder->type == DEC_UART) {
+		for (unsigned int j = 0; j < levels->size; j++)
+			oXs_decoder_uart_step(decoder, p + j, (x[j] > 0.5)? 1 : 0);
+	} else if (decoder->type == DEC_I2C) {
+		for (unsigned int j = 0; j < levels->size; j++)
+			oXs_decoder_i2c_step(decoder, p + j, (x[j] > 0.5)? 1 : 0, (y[j] > 0.5)? 1 : 0);
+	} else {
+		for (unsigned int j = 0; j < levels->size; j++)
+			oXs_decoder_pulse_step(decoder, p + j, (x[j] > 0.5)? 1 : 0);
+	}
+	decoder->position += levels->size;
+	if (decoder->unflushed) {
+		fflush(decoder->output);
+		decoder->unflushed = false;
+	}
+
+	unsigned long oldest = (decoder->position > decoder->span)? decoder->position - decoder->span : 0;
+	while ((decoder->nr_symbols > 0) && (oXs_decoder_symbol(decoder, 0).end < oldest))
+		oXs_decoder_drop(decoder);
+
+	return;
+}
+
+// Gnuplot labels for the symbols within the nr_samples positions starting
+// at start, placed above the decoded channel (channels are stacked as in
+// the digital plot), with the time axis of oXs_logic_trace_fill.
+void oXs_decoder_labels(const ProtocolDecoder* decoder, std::vector<std::string> & labels, unsigned long start, unsigned int nr_samples, double dt, double origin)
+{
+	labels.clear();
+	if (decoder->type == DEC_NONE)
+		return;
+	unsigned int channel = (decoder->type == DEC_I2C)? 1 : decoder->channel;
+	double y = 1.2 * (decoder->nr_channels - 1 - channel) + 1.1;
+	char text[16];
+	char label[256];
+	for (unsigned int i = 0; (i < decoder->nr_symbols) && (labels.size() < DECODER_MAX_LABELS); i++) {
+		const DecodedSymbol& symbol = oXs_decoder_symbol(decoder, i);
+		unsigned long middle = (symbol.start + symbol.end) / 2;
+		if ((middle < start) || (middle >= start + nr_samples))
+			continue;
+		if ((symbol.kind == 'D') && (decoder->type == DEC_I2C))
+			sprintf(text, "%02X%c", symbol.value, (symbol.ack)? 'A' : 'N');
+		else if (symbol.kind == 'D')
+			sprintf(text, "%02X", symbol.value);
+		else if (symbol.kind == 'E')
+			sprintf(text, "err");
+		else
+			sprintf(text, "%c", symbol.kind);
+		sprintf(label, "label %u \"%s\" at first %g, first %g center textcolor rgb '#d0d0d0' font \"mbfont:Courier,9\" front", (unsigned int) labels.size() + 1, text, (origin + (double) (middle - start)) * dt, y);
+		labels.push_back(label);
+	}
+
+	return;
+}
@@ -0,0 +1,104 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_DECODER_H
+#define XOSCILLOSCOPE_ENGINE_DECODER_H
+
+#include <cstdio>
+#include <vector>
+#include <string>
+
+#include "xoscilloscope-engine_digital.h"
+
+#define DECODER_MAX_SYMBOLS 4096	// a power of two
+#define DECODER_MAX_LABELS 64
+#define DECODER_DEFAULT_BAUD 300.0
+
+enum decoder_type : unsigned int {
+	DEC_NONE,
+	DEC_UART,
+	DEC_I2C,
+	DEC_PULSE
+};
+
+// A decoded symbol spans the positions from start to end, counted like
+// those of the logic trace (see xoscilloscope-engine_digital.h). Kinds are
+// 'D' (a data byte, with its acknowledge bit for I2C), 'S' and 'P' (I2C
+// start and stop conditions) and 'E' (UART framing error).
+struct DecodedSymbol {
+	unsigned long	start;
+	unsigned long	end;
+	char		kind;
+	unsigned char	value;
+	bool		ack;
+};
+
+// Protocol decoders run on the logic levels as they are acquired, one
+// sample at a time, so that their cost does not depend on the time scale:
+// - UART on `channel`, idle high, 8 data bits (LSB first), no parity, one
+//   stop bit, at bit_samples samples per bit; bits are read at their middle,
+//   timed from the falling edge of the start bit;
+// - I2C, with the clock on channel 1 and the data on channel 2: start and
+//   stop conditions are data edges while the clock is high, and bits (MSB
+//   first, then the acknowledge bit) are read at the rising clock edges;
+// - pulse code on `channel`: every high pulse is a bit, 1 if longer than 1.5
+//   bit times, 0 otherwise, MSB first; a low level longer than 4 bit times
+//   drops an incomplete byte.
+// A gap resets the decoder. The latest span positions of symbols are kept
+// for the display, in a fixed ring of DECODER_MAX_SYMBOLS from symbol_head
+// on, allocated at reset, the oldest symbol giving way when it is full;
+// data bytes are also written to output, if any, as they are decoded.
+struct ProtocolDecoder {
+	decoder_type		type;
+	unsigned int		channel;
+	unsigned int		nr_channels;
+	double			bit_samples;
+	unsigned long		span;
+	unsigned long		position;
+	bool			active;
+	unsigned char		previous[2];
+	unsigned long		start;
+	unsigned long		edge;
+	double			next_bit;
+	unsigned int		nr_bits;
+	unsigned int		bits;
+	std::vector<DecodedSymbol>	symbols;
+	unsigned int		symbol_head;
+	unsigned int		nr_symbols;
+	FILE*			output;
+	bool			unflushed;
+};
+
+// Symbol i, the oldest kept being symbol 0.
+inline const DecodedSymbol& oXs_decoder_symbol(const ProtocolDecoder* decoder, unsigned int i)
+{
+	return decoder->symbols[(decoder->symbol_head + i) & (DECODER_MAX_SYMBOLS - 1)];
+}
+
+void oXs_decoder_init(ProtocolDecoder*, FILE*);
+void oXs_decoder_reset(ProtocolDecoder*, decoder_type, unsigned int, unsigned int, double, unsigned long);
+void oXs_decoder_push_period(ProtocolDecoder*, const PeriodBlock*);
+void oXs_decoder_labels(const ProtocolDecoder*, std::vector<std::string> &, unsigned long, unsigned int, double, double);
+
+#endif
@@ -0,0 +1,265 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <cmath>
+#include <algorithm>
+
+#include "xoscilloscope-engine_digital.h"
+
+void oXs_logic_detector_reset(LogicDetector* detector, unsigned int nr_channels, unsigned int window, double threshold)
+{
+	detector->nr_channels = nr_channels;
+	detector->window = (window < 1)? 1 : ((window > DIG_SR_MAX_SIZE)? DIG_SR_MAX_SIZE : window);
+	detector->threshold = threshold;
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++)
+		detector->history[c].assign((c < nr_channels)? detector->window : 0, 0.0);
+	oXs_logic_detector_clear(detector);
+
+	return;
+}
+
+void oXs_logic_detector_clear(LogicDetector* detector)
+{
+	for (unsigned int c = 0; c < detector->nr_channels; c++) {
+		std::fill(detector->history[c].begin(), detector->history[c].end(), 0.0);
+		detector->sum[c] = 0.0;
+		detector->sum_squares[c] = 0.0;
+	}
+	detector->fill = 0;
+	detector->next = 0;
+
+	return;
+}
+
+// Converts a period of samples into a period of logic levels (0 or 1),
+// channel by channel. Samples not yet in the window count as zeros, so that
+// the window can be filling up; the variance is compared with the squared
+// threshold.
+void oXs_logic_detector_process(LogicDetector* detector, const PeriodBlock* block, PeriodBlock* levels)
+{
+	if (block->gap_frames > 0)
+		oXs_logic_detector_clear(detector);
+
+	unsigned int window = detector->window;
+	double threshold = detector->threshold * detector->threshold;
+	unsigned int fill = detector->fill, next = detector->next;
+	for (unsigned int c = 0; c < detector->nr_channels; c++) {
+		const float* x = block->samples[c];
+		float* y = levels->samples[c];
+		float* h = detector->history[c].data();
+		double s = detector->sum[c], s2 = detector->sum_squares[c];
+		fill = detector->fill;
+		next = detector->next;
+		for (unsigned int j = 0; j < block->size; j++) {
+			double v = x[j], old = h[next];
+			h[next] = x[j];
+			s += v - old;
+			s2 += v * v - old * old;
+			if (fill < window)
+				fill++;
+			if (++next == window) {
+				next = 0;
+				s = 0.0;
+				s2 = 0.0;
+				for (unsigned int i = 0; i < window; i++) {
+					s += h[i];
+					s2 += (double) h[i] * h[i];
+				}
+			}
+			double m = s / fill;
+			y[j] = (s2 / fill - m * m < threshold)? 0.0 : 1.0;
+		}
+		detector->sum[c] = s;
+		detector->sum_squares[c] = s2;
+	}
+	detector->fill = fill;
+	detector->next = next;
+	levels->size = block->size;
+	levels->gap_frames = block->gap_frames;
+
+	return;
+}
+
+void oXs_logic_trace_reset(LogicTrace* trace, unsigned int nr_channels, unsigned long span)
+{
+	trace->nr_channels = nr_channels;
+	trace->span = span;
+	trace->position = 0;
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++) {
+		trace->level[c] = LOGIC_UNKNOWN;
+		trace->first_level[c] = LOGIC_UNKNOWN;
+		trace->begin[c] = 0;
+		if (c < nr_channels)
+			trace->edges[c].resize(DIG_MAX_EDGES);
+		trace->edge_head[c] = 0;
+		trace->nr_edges[c] = 0;
+	}
+
+	return;
+}
+
+// Forgets the oldest transition of channel c, remembering the level it set.
+static inline void oXs_logic_trace_drop(LogicTrace* trace, unsigned int c)
+{
+	const LogicEdge& edge = oXs_logic_trace_edge(trace, c, 0);
+	trace->first_level[c] = edge.level;
+	trace->begin[c] = edge.position;
+	trace->edge_head[c] = (trace->edge_head[c] + 1) & (DIG_MAX_EDGES - 1);
+	trace->nr_edges[c]--;
+}
+
+// When the ring is full, the oldest transition makes room for the new one.
+static inline void oXs_logic_trace_append(LogicTrace* trace, unsigned int c, unsigned long position, unsigned char level)
+{
+	if (trace->nr_edges[c] == DIG_MAX_EDGES)
+		oXs_logic_trace_drop(trace, c);
+	LogicEdge& edge = trace->edges[c][(trace->edge_head[c] + trace->nr_edges[c]) & (DIG_MAX_EDGES - 1)];
+	edge.position = position;
+	edge.level = level;
+	trace->nr_edges[c]++;
+	trace->level[c] = level;
+}
+
+// Forgets the transitions that precede the kept span.
+static void oXs_logic_trace_prune(LogicTrace* trace, unsigned int c)
+{
+	unsigned long oldest = (trace->position > trace->span)? trace->position - trace->span : 0;
+	while ((trace->nr_edges[c] > 0) && (oXs_logic_trace_edge(trace, c, 0).position <= oldest))
+		oXs_logic_trace_drop(trace, c);
+	if (trace->begin[c] < oldest)
+		trace->begin[c] = oldest;
+
+	return;
+}
+
+// Appends a period of logic levels (see oXs_logic_detector_process); a gap
+// preceding it takes one position, at which the levels become unknown.
+void oXs_logic_trace_push_period(LogicTrace* trace, const PeriodBlock* levels)
+{
+	if (levels->gap_frames > 0) {
+		for (unsigned int c = 0; c < trace->nr_channels; c++) {
+			if (trace->level[c] != LOGIC_UNKNOWN)
+				oXs_logic_trace_append(trace, c, trace->position, LOGIC_UNKNOWN);
+		}
+		trace->position++;
+	}
+	for (unsigned int c = 0; c < trace->nr_channels; c++) {
+		const float* y = levels->samples[c];
+		unsigned char level = trace->level[c];
+		for (unsigned int j = 0; j < levels->size; j++) {
+			unsigned char l = (y[j] > 0.5)? 1 : 0;
+			if (l != level) {
+				oXs_logic_trace_append(trace, c, trace->position + j, l);
+				level = l;
+			}
+		}
+	}
+	trace->position += levels->size;
+	for (unsigned int c = 0; c < trace->nr_channels; c++)
+		oXs_logic_trace_prune(trace, c);
+
+	return;
+}
+
+// Index of the first transition of channel c after position.
+static unsigned long oXs_logic_trace_after(const LogicTrace* trace, unsigned int c, unsigned long position)
+{
+	unsigned long lo = 0, hi = trace->nr_edges[c];
+	while (lo < hi) {
+		unsigned long mid = (lo + hi) / 2;
+		if (oXs_logic_trace_edge(trace, c, mid).position <= position)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	return lo;
+}
+
+// Level of channel c at position, unknown if it is no longer kept.
+unsigned char oXs_logic_trace_level_at(const LogicTrace* trace, unsigned int c, unsigned long position)
+{
+	if (position < trace->begin[c])
+		return LOGIC_UNKNOWN;
+	unsigned long i = oXs_logic_trace_after(trace, c, position);
+
+	return (i > 0)? oXs_logic_trace_edge(trace, c, i - 1).level : trace->first_level[c];
+}
+
+// Position of the first rising (0 to 1) or falling (1 to 0) edge of channel
+// c at or after position, or -1; transitions from or to an unknown level
+// are not edges.
+long oXs_logic_trace_next_edge(const LogicTrace* trace, unsigned int c, unsigned long position, bool rising)
+{
+	unsigned char from = (rising)? 0 : 1;
+	unsigned long i = oXs_logic_trace_after(trace, c, (position > 0)? position - 1 : 0);
+	if ((position == 0) && (trace->nr_edges[c] > 0) && (oXs_logic_trace_edge(trace, c, 0).position == 0))
+		i = 0;
+	unsigned char previous = (i > 0)? oXs_logic_trace_edge(trace, c, i - 1).level : trace->first_level[c];
+	for (; i < trace->nr_edges[c]; i++) {
+		const LogicEdge& edge = oXs_logic_trace_edge(trace, c, i);
+		if ((previous == from) && (edge.level == 1 - from))
+			return edge.position;
+		previous = edge.level;
+	}
+
+	return -1;
+}
+
+// Writes the nr_samples positions starting at start as a step plot: a row
+// at the start, one row at each transition of any channel, with the levels
+// that begin there, and a row at the end. The first position is plotted at
+// t = origin samples; unknown levels are NaN.
+void oXs_logic_trace_fill(LogicTrace* trace, std::vector< std::vector<double> > & gnuplot_data, unsigned long start, unsigned int nr_samples, double dt, double origin)
+{
+	unsigned long end = start + nr_samples;
+	unsigned long next[MAX_CHANNELS];
+	unsigned char level[MAX_CHANNELS];
+	std::vector<unsigned long>& times = trace->times;
+	times.assign(1, start);
+	for (unsigned int c = 0; c < trace->nr_channels; c++) {
+		next[c] = oXs_logic_trace_after(trace, c, start);
+		level[c] = oXs_logic_trace_level_at(trace, c, start);
+		for (unsigned long i = next[c]; (i < trace->nr_edges[c]) && (oXs_logic_trace_edge(trace, c, i).position < end); i++)
+			times.push_back(oXs_logic_trace_edge(trace, c, i).position);
+	}
+	std::sort(times.begin(), times.end());
+	times.erase(std::unique(times.begin(), times.end()), times.end());
+	times.push_back(end);
+
+	unsigned int nr_columns = trace->nr_channels + 1;
+	if ((gnuplot_data.size() != times.size()) || (gnuplot_data[0].size() != nr_columns))
+		gnuplot_data.assign(times.size(), std::vector<double>(nr_columns, 0.0));
+	for (unsigned int r = 0; r < times.size(); r++) {
+		unsigned long t = times[r];
+		gnuplot_data[r][0] = (origin + (double) (t - start)) * dt;
+		for (unsigned int c = 0; c < trace->nr_channels; c++) {
+			while ((next[c] < trace->nr_edges[c]) && (oXs_logic_trace_edge(trace, c, next[c]).position <= t) && (oXs_logic_trace_edge(trace, c, next[c]).position < end))
+				level[c] = oXs_logic_trace_edge(trace, c, next[c]++).level;
+			gnuplot_data[r][c + 1] = (level[c] == LOGIC_UNKNOWN)? NAN : (double) level[c];
+		}
+	}
+
+	return;
+}
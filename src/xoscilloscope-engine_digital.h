@@ -0,0 +1,101 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_DIGITAL_H
+#define XOSCILLOSCOPE_ENGINE_DIGITAL_H
+
+#include <vector>
+
+#include "xoscilloscope-engine_buffer.h"
+
+#define DIG_SR_SIZE 24
+#define DIG_SR_MAX_SIZE 4096
+#define DIG_SIG_THR 8192
+#define DIG_MAX_EDGES 65536	// a power of two
+#define LOGIC_UNKNOWN 2
+
+// Logic level detection: a channel is at level 1 when the standard
+// deviation of its latest `window` samples reaches the threshold (i.e. a
+// carrier is present), at level 0 otherwise. Each channel keeps a circular
+// window of samples with their running sum and sum of squares, updated in
+// O(1) per sample; the sums are recomputed from the window each time it
+// wraps around, so that rounding errors cannot build up. After a gap, the
+// window starts filling up again.
+struct LogicDetector {
+	unsigned int		nr_channels;
+	unsigned int		window;
+	unsigned int		fill;
+	unsigned int		next;
+	double			threshold;
+	std::vector<float>	history[MAX_CHANNELS];
+	double			sum[MAX_CHANNELS];
+	double			sum_squares[MAX_CHANNELS];
+};
+
+void oXs_logic_detector_reset(LogicDetector*, unsigned int, unsigned int, double);
+void oXs_logic_detector_clear(LogicDetector*);
+void oXs_logic_detector_process(LogicDetector*, const PeriodBlock*, PeriodBlock*);
+
+// Digital captures are kept as lists of transitions, each with the position
+// of the sample at which the new level starts, positions being counted like
+// those of the trigger scan (a gap takes one position, and makes the level
+// unknown). Only the latest span positions are kept, and at most
+// DIG_MAX_EDGES transitions per channel: first_level is the level at the
+// first position kept (begin), before the first transition. Memory thus
+// depends on the activity of the signals, not on the time scale. The
+// transitions of each channel are kept in a fixed ring of DIG_MAX_EDGES,
+// from edge_head on, allocated once; times is the scratch list of
+// transition positions merged by oXs_logic_trace_fill, kept from one
+// refresh to the next.
+struct LogicEdge {
+	unsigned long	position;
+	unsigned char	level;
+};
+
+struct LogicTrace {
+	unsigned int		nr_channels;
+	unsigned long		span;
+	unsigned long		position;
+	unsigned char		level[MAX_CHANNELS];
+	unsigned char		first_level[MAX_CHANNELS];
+	unsigned long		begin[MAX_CHANNELS];
+	std::vector<LogicEdge>	edges[MAX_CHANNELS];
+	unsigned long		edge_head[MAX_CHANNELS];
+	unsigned long		nr_edges[MAX_CHANNELS];
+	std::vector<unsigned long>	times;
+};
+
+// Transition i of channel c, the oldest kept being transition 0.
+inline const LogicEdge& oXs_logic_trace_edge(const LogicTrace* trace, unsigned int c, unsigned long i)
+{
+	return trace->edges[c][(trace->edge_head[c] + i) & (DIG_MAX_EDGES - 1)];
+}
+
+void oXs_logic_trace_reset(LogicTrace*, unsigned int, unsigned long);
+void oXs_logic_trace_push_period(LogicTrace*, const PeriodBlock*);
+unsigned char oXs_logic_trace_level_at(const LogicTrace*, unsigned int, unsigned long);
+long oXs_logic_trace_next_edge(const LogicTrace*, unsigned int, unsigned long, bool);
+void oXs_logic_trace_fill(LogicTrace*, std::vector< std::vector<double> > &, unsigned long, unsigned int, double, double);
+
+#endif
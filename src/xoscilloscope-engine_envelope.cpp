@@ -0,0 +1,229 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <cmath>
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+#endif
+
+#include "xoscilloscope-engine_envelope.h"
+
+// Comparisons involving NaN are false, so that NaN samples leave the
+// extrema untouched.
+static void oXs_extrema_scalar(const float* x, unsigned int n, float* lo, float* hi)
+{
+	float a = *lo, b = *hi;
+	for (unsigned int i = 0; i < n; i++) {
+		a = (x[i] < a)? x[i] : a;
+		b = (x[i] > b)? x[i] : b;
+	}
+	*lo = a;
+	*hi = b;
+
+	return;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// minps/maxps return their second operand when either one is NaN: samples
+// are passed first, so that gap markers are skipped without branches. The
+// lanes are reduced at the end, and the tail is handled by the scalar
+// kernel.
+__attribute__((target("sse2")))
+static void oXs_extrema_sse2(const float* x, unsigned int n, float* lo, float* hi)
+{
+	if (n < 8) {
+		oXs_extrema_scalar(x, n, lo, hi);
+		return;
+	}
+	__m128 a = _mm_set1_ps(*lo), b = _mm_set1_ps(*hi);
+	unsigned int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128 v = _mm_loadu_ps(x + i);
+		a = _mm_min_ps(v, a);
+		b = _mm_max_ps(v, b);
+	}
+	float la[4], lb[4];
+	_mm_storeu_ps(la, a);
+	_mm_storeu_ps(lb, b);
+	for (unsigned int k = 1; k < 4; k++) {
+		la[0] = (la[k] < la[0])? la[k] : la[0];
+		lb[0] = (lb[k] > lb[0])? lb[k] : lb[0];
+	}
+	*lo = la[0];
+	*hi = lb[0];
+	oXs_extrema_scalar(x + i, n - i, lo, hi);
+
+	return;
+}
+
+__attribute__((target("avx2")))
+static void oXs_extrema_avx2(const float* x, unsigned int n, float* lo, float* hi)
+{
+	if (n < 16) {
+		oXs_extrema_scalar(x, n, lo, hi);
+		return;
+	}
+	__m256 a = _mm256_set1_ps(*lo), b = _mm256_set1_ps(*hi);
+	unsigned int i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 v = _mm256_loadu_ps(x + i);
+		a = _mm256_min_ps(v, a);
+		b = _mm256_max_ps(v, b);
+	}
+	float la[8], lb[8];
+	_mm256_storeu_ps(la, a);
+	_mm256_storeu_ps(lb, b);
+	for (unsigned int k = 1; k < 8; k++) {
+		la[0] = (la[k] < la[0])? la[k] : la[0];
+		lb[0] = (lb[k] > lb[0])? lb[k] : lb[0];
+	}
+	*lo = la[0];
+	*hi = lb[0];
+	oXs_extrema_scalar(x + i, n - i, lo, hi);
+
+	return;
+}
+
+#endif
+
+ExtremaKernel oXs_select_extrema_kernel()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return oXs_extrema_avx2;
+	if (__builtin_cpu_supports("sse2"))
+		return oXs_extrema_sse2;
+#endif
+	return oXs_extrema_scalar;
+}
+
+// Columns span decimation samples each, the last one possibly fewer.
+void oXs_envelope_reset(WaveformEnvelope* envelope, unsigned int nr_channels, unsigned int trace_size, unsigned int depth)
+{
+	if (trace_size < 1)
+		trace_size = 1;
+	envelope->extrema = oXs_select_extrema_kernel();
+	envelope->nr_channels = nr_channels;
+	envelope->trace_size = trace_size;
+	envelope->decimation = (trace_size + ENVELOPE_COLUMNS - 1) / ENVELOPE_COLUMNS;
+	envelope->nr_columns = (trace_size + envelope->decimation - 1) / envelope->decimation;
+	envelope->depth = depth;
+	unsigned long size = (unsigned long) envelope->nr_columns * ((depth > 0)? depth : 1);
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++) {
+		envelope->minimum[c].assign((c < nr_channels)? size : 0, INFINITY);
+		envelope->maximum[c].assign((c < nr_channels)? size : 0, -INFINITY);
+	}
+	envelope->count = 0;
+	envelope->slot = 0;
+
+	return;
+}
+
+void oXs_envelope_clear(WaveformEnvelope* envelope)
+{
+	for (unsigned int c = 0; c < envelope->nr_channels; c++) {
+		std::fill(envelope->minimum[c].begin(), envelope->minimum[c].end(), INFINITY);
+		std::fill(envelope->maximum[c].begin(), envelope->maximum[c].end(), -INFINITY);
+	}
+	envelope->count = 0;
+	envelope->slot = 0;
+
+	return;
+}
+
+// Enters a waveform laid out in one piece (see oXs_average_add). With a
+// finite depth, its column extrema replace those of the oldest waveform.
+bool oXs_envelope_add(WaveformEnvelope* envelope, const TraceBuffer* waveform)
+{
+	unsigned int n = envelope->trace_size;
+	if (waveform->count != n)
+		return false;
+
+	unsigned int first = oXs_trace_buffer_index(waveform, 0);
+	unsigned int d = envelope->decimation;
+	unsigned long offset = (unsigned long) envelope->slot * envelope->nr_columns;
+	for (unsigned int c = 0; c < envelope->nr_channels; c++) {
+		const float* x = waveform->samples[c] + first;
+		float* lo = envelope->minimum[c].data() + offset;
+		float* hi = envelope->maximum[c].data() + offset;
+		for (unsigned int j = 0; j < envelope->nr_columns; j++) {
+			if (envelope->depth > 0) {
+				lo[j] = INFINITY;
+				hi[j] = -INFINITY;
+			}
+			envelope->extrema(x + j * d, std::min(d, n - j * d), lo + j, hi + j);
+		}
+	}
+	if (envelope->depth > 0) {
+		if (envelope->count < envelope->depth)
+			envelope->count++;
+		envelope->slot = (envelope->slot + 1 < envelope->depth)? envelope->slot + 1 : 0;
+	} else {
+		envelope->count++;
+	}
+
+	return true;
+}
+
+// Writes, for each column, a row with the minima and a row with the maxima,
+// both at the time of the first sample of the column, the first sample of
+// the trace being at t = origin samples; a single row is enough for peak
+// detect without decimation. Columns without valid samples are NaN, which
+// breaks the traces.
+void oXs_envelope_fill(const WaveformEnvelope* envelope, std::vector< std::vector<double> > & gnuplot_data, double dt, const double* k, double origin)
+{
+	unsigned int nr_slots = (envelope->depth > 0)? envelope->count : ((envelope->count > 0)? 1 : 0);
+	unsigned int rows_per_column = ((envelope->depth == 1) && (envelope->decimation == 1))? 1 : 2;
+	unsigned int nr_rows = rows_per_column * envelope->nr_columns;
+	unsigned int nr_columns = envelope->nr_channels + 1;
+	if ((gnuplot_data.size() != nr_rows) || (gnuplot_data[0].size() != nr_columns))
+		gnuplot_data.assign(nr_rows, std::vector<double>(nr_columns, 0.0));
+
+	for (unsigned int j = 0; j < envelope->nr_columns; j++) {
+		double t = (origin + (double) j * envelope->decimation) * dt;
+		for (unsigned int r = 0; r < rows_per_column; r++)
+			gnuplot_data[rows_per_column * j + r][0] = t;
+	}
+	for (unsigned int c = 0; c < envelope->nr_channels; c++) {
+		const float* minimum = envelope->minimum[c].data();
+		const float* maximum = envelope->maximum[c].data();
+		for (unsigned int j = 0; j < envelope->nr_columns; j++) {
+			float lo = INFINITY, hi = -INFINITY;
+			for (unsigned int s = 0; s < nr_slots; s++) {
+				unsigned long m = (unsigned long) s * envelope->nr_columns + j;
+				lo = (minimum[m] < lo)? minimum[m] : lo;
+				hi = (maximum[m] > hi)? maximum[m] : hi;
+			}
+			bool valid = (lo <= hi);
+			gnuplot_data[rows_per_column * j][c + 1] = (valid)? lo * k[c] : NAN;
+			if (rows_per_column > 1)
+				gnuplot_data[rows_per_column * j + 1][c + 1] = (valid)? hi * k[c] : NAN;
+		}
+	}
+
+	return;
+}
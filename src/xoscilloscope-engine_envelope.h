@@ -0,0 +1,75 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_ENVELOPE_H
+#define XOSCILLOSCOPE_ENGINE_ENVELOPE_H
+
+#include <vector>
+
+#include "xoscilloscope-engine_buffer.h"
+
+#define ENVELOPE_COLUMNS 700
+
+// Updates *lo and *hi with the minimum and the maximum of n samples; NaN
+// samples (gap markers) are ignored.
+typedef void (*ExtremaKernel)(const float*, unsigned int, float*, float*);
+
+ExtremaKernel oXs_select_extrema_kernel();
+
+// Besides sampling (plain or averaged), triggered analog traces can be
+// acquired in peak-detect mode, where each of the ENVELOPE_COLUMNS columns
+// of the screen shows the minimum and the maximum of the samples it spans,
+// so that glitches narrower than a column are not lost; or in envelope
+// mode, where the minima and maxima of each column are further taken over
+// the latest waveforms.
+enum acquisition_mode : unsigned int {
+	ACQ_SAMPLE,
+	ACQ_PEAK_DETECT,
+	ACQ_ENVELOPE
+};
+
+// Column-wise minima and maxima of the latest depth waveforms (peak detect:
+// depth = 1), kept in a ring of depth waveforms' worth of columns; with
+// depth = 0, extrema accumulate over all waveforms until cleared. Extrema
+// are not resampled at the sub-sample trigger instant, which would flatten
+// them; they are taken on raw samples, and scaled when plotted.
+struct WaveformEnvelope {
+	ExtremaKernel		extrema;
+	unsigned int		nr_channels;
+	unsigned int		trace_size;
+	unsigned int		decimation;
+	unsigned int		nr_columns;
+	unsigned int		depth;
+	unsigned int		count;
+	unsigned int		slot;
+	std::vector<float>	minimum[MAX_CHANNELS];
+	std::vector<float>	maximum[MAX_CHANNELS];
+};
+
+void oXs_envelope_reset(WaveformEnvelope*, unsigned int, unsigned int, unsigned int);
+void oXs_envelope_clear(WaveformEnvelope*);
+bool oXs_envelope_add(WaveformEnvelope*, const TraceBuffer*);
+void oXs_envelope_fill(const WaveformEnvelope*, std::vector< std::vector<double> > &, double, const double*, double);
+
+#endif
@@ -0,0 +1,164 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <cstring>
+#include <cstdint>
+#include <cmath>
+
+#include "xoscilloscope-engine_format.h"
+
+// One traits structure per capture format: byte width and conversion of a
+// single little-endian sample to units. Everything is resolved at compile
+// time, so each instance of the kernel below is a tight, branch-free loop.
+template <snd_pcm_format_t FORMAT> struct SampleFormat;
+
+template <> struct SampleFormat<SND_PCM_FORMAT_S16_LE> {
+	static const unsigned int width = 2;
+	static inline float toUnits(const unsigned char* p)
+	{
+		int16_t v;
+		memcpy(&v, p, sizeof(v));
+		return (float) v;
+	}
+};
+
+template <> struct SampleFormat<SND_PCM_FORMAT_S24_3LE> {
+	static const unsigned int width = 3;
+	static inline float toUnits(const unsigned char* p)
+	{
+		int32_t v = (int32_t) (((uint32_t) p[0] << 8) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 24)) >> 8;
+		return (float) v * (1.0f / 256.0f);
+	}
+};
+
+template <> struct SampleFormat<SND_PCM_FORMAT_S32_LE> {
+	static const unsigned int width = 4;
+	static inline float toUnits(const unsigned char* p)
+	{
+		int32_t v;
+		memcpy(&v, p, sizeof(v));
+		return (float) v * (1.0f / 65536.0f);
+	}
+};
+
+template <> struct SampleFormat<SND_PCM_FORMAT_FLOAT_LE> {
+	static const unsigned int width = 4;
+	static inline float toUnits(const unsigned char* p)
+	{
+		float v;
+		memcpy(&v, p, sizeof(v));
+		return v * 32768.0f;
+	}
+};
+
+// Deinterleaves a period of nr_frames frames, each made of nr_channels
+// samples, into the per-channel arrays of a PeriodBlock. Sources with fewer
+// channels than the block have their last channel replicated.
+template <snd_pcm_format_t FORMAT>
+static void oXs_deinterleave(const unsigned char* raw, PeriodBlock* block, unsigned int nr_frames, unsigned int nr_channels)
+{
+	const unsigned int width = SampleFormat<FORMAT>::width;
+	const unsigned int stride = width * nr_channels;
+	for (unsigned int c = 0; c < block->nr_channels; c++) {
+		const unsigned char* src = raw + width * ((c < nr_channels)? c : nr_channels - 1);
+		float* __restrict__ dst = block->samples[c];
+		for (unsigned int i = 0; i < nr_frames; i++)
+			dst[i] = SampleFormat<FORMAT>::toUnits(src + i * stride);
+	}
+	block->size = nr_frames;
+
+	return;
+}
+
+DeinterleaveKernel oXs_select_deinterleave_kernel(snd_pcm_format_t format)
+{
+	switch (format) {
+		case SND_PCM_FORMAT_S24_3LE:
+			return oXs_deinterleave<SND_PCM_FORMAT_S24_3LE>;
+		case SND_PCM_FORMAT_S32_LE:
+			return oXs_deinterleave<SND_PCM_FORMAT_S32_LE>;
+		case SND_PCM_FORMAT_FLOAT_LE:
+			return oXs_deinterleave<SND_PCM_FORMAT_FLOAT_LE>;
+		case SND_PCM_FORMAT_S16_LE:
+		default:
+			return oXs_deinterleave<SND_PCM_FORMAT_S16_LE>;
+	}
+}
+
+unsigned int oXs_format_width(snd_pcm_format_t format)
+{
+	switch (format) {
+		case SND_PCM_FORMAT_S24_3LE:
+			return SampleFormat<SND_PCM_FORMAT_S24_3LE>::width;
+		case SND_PCM_FORMAT_S32_LE:
+			return SampleFormat<SND_PCM_FORMAT_S32_LE>::width;
+		case SND_PCM_FORMAT_FLOAT_LE:
+			return SampleFormat<SND_PCM_FORMAT_FLOAT_LE>::width;
+		case SND_PCM_FORMAT_S16_LE:
+		default:
+			return SampleFormat<SND_PCM_FORMAT_S16_LE>::width;
+	}
+}
+
+bool oXs_parse_format(const std::string& name, snd_pcm_format_t* format)
+{
+	if (name == "s16") {
+		*format = SND_PCM_FORMAT_S16_LE;
+	} else if (name == "s24") {
+		*format = SND_PCM_FORMAT_S24_3LE;
+	} else if (name == "s32") {
+		*format = SND_PCM_FORMAT_S32_LE;
+	} else if (name == "float") {
+		*format = SND_PCM_FORMAT_FLOAT_LE;
+	} else if (name == "auto") {
+		*format = SND_PCM_FORMAT_UNKNOWN;
+	} else {
+		return false;
+	}
+
+	return true;
+}
+
+// Inverse conversion, from units to one sample of the given format; only
+// used to produce synthetic test signals.
+void oXs_encode_sample(unsigned char* p, snd_pcm_format_t format, double value)
+{
+	if (format == SND_PCM_FORMAT_S24_3LE) {
+		int32_t v = (int32_t) lrint(value * 256.0);
+		p[0] = v & 0xff;
+		p[1] = (v >> 8) & 0xff;
+		p[2] = (v >> 16) & 0xff;
+	} else if (format == SND_PCM_FORMAT_S32_LE) {
+		int32_t v = (int32_t) lrint(value * 65536.0);
+		memcpy(p, &v, sizeof(v));
+	} else if (format == SND_PCM_FORMAT_FLOAT_LE) {
+		float v = (float) (value / 32768.0);
+		memcpy(p, &v, sizeof(v));
+	} else {
+		int16_t v = (int16_t) lrint(value);
+		memcpy(p, &v, sizeof(v));
+	}
+
+	return;
+}
@@ -0,0 +1,45 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_FORMAT_H
+#define XOSCILLOSCOPE_ENGINE_FORMAT_H
+
+#include <string>
+#include <alsa/asoundlib.h>
+
+#include "xoscilloscope-engine_buffer.h"
+
+// Samples are converted to floating point "units" of a 16-bit converter,
+// whatever the capture format: a full-scale S16 sample is 32767 units, so
+// that vertical scales, trigger levels and calibrations do not depend on
+// the format, while S24/S32/FLOAT keep their extra resolution as fraction
+// of a unit.
+typedef void (*DeinterleaveKernel)(const unsigned char*, PeriodBlock*, unsigned int, unsigned int);
+
+DeinterleaveKernel oXs_select_deinterleave_kernel(snd_pcm_format_t);
+unsigned int oXs_format_width(snd_pcm_format_t);
+bool oXs_parse_format(const std::string&, snd_pcm_format_t*);
+void oXs_encode_sample(unsigned char*, snd_pcm_format_t, double);
+
+#endif
@@ -28,22 +28,36 @@
 int main (int argc, char *argv[])
 {
 	int err, readbytes;
-	int16_t * buf = (int16_t *) malloc(sizeof(int16_t) * BUF_SIZE * CHN_SIZE);
-	snd_pcm_t *device_handle;
-	snd_pcm_hw_params_t *device_parameters;
-	unsigned int sample_rate = SAMPLING_RATE;
+	PeriodBlock block, levels;
+	unsigned int sample_rate, period_size, nr_channels;
+	EngineOptions engine_options;
+	oXs_default_engine_options(&engine_options);
+	oXs_parse_command_line(argc, argv, &engine_options);
 
 	requested_termination = false;
 	signal(SIGINT, signalHandler);
-
-	std::cerr << "Setting up acquisition device...";
-	if (snd_pcm_open (&device_handle, "default", SND_PCM_STREAM_CAPTURE, 0) < 0) {
-		std::cerr <<  "Could not open audio device <default>\n",
-		exit(1);
+	// Writes to the generator pipe of the Bode mode fail, instead of
+	// terminating the engine, when wavex goes away.
+	signal(SIGPIPE, SIG_IGN);
+
+	std::cerr << "Setting up acquisition source...";
+	AcquisitionSource* source = oXs_create_source(engine_options.source_spec, engine_options.device_name, engine_options.access, engine_options.format, engine_options.nr_channels, engine_options.pace_realtime, engine_options.sample_rate, engine_options.period_size, engine_options.buffer_size);
+	sample_rate = source->sample_rate;
+	period_size = source->period_size;
+	nr_channels = (source->nr_channels < 2)? 2 : source->nr_channels;
+	if (nr_channels > MAX_CHANNELS) {
+		std::cerr << " only the first " << MAX_CHANNELS << " of " << nr_channels << " channels will be displayed...";
+		nr_channels = MAX_CHANNELS;
 	}
-	oXs_hardware_setup_capture(device_handle, device_parameters, &sample_rate);
-	snd_pcm_hw_params_free(device_parameters);
-	std::cerr << " done.\n";
+	CaptureThread capture;
+	oXs_period_block_allocate(&block, period_size, nr_channels);
+	oXs_period_block_allocate(&levels, period_size, nr_channels);
+	oXs_capture_start(&capture, source, nr_channels);
+	FILE* decoder_output = NULL;
+	if (!engine_options.decoder_output.empty() && ((decoder_output = fopen(engine_options.decoder_output.c_str(), "ab")) == NULL))
+		std::cerr << " could not open '" << engine_options.decoder_output << "' for decoded data...";
+	std::cerr << " done (" << source->description << ").\n";
+	std::cerr << "Sampling rate " << sample_rate << " Hz, period " << period_size << " frames, buffer " << source->buffer_size << " frames, " << nr_channels << " channels.\n";
 
 	std::cerr << "Setting up connection with console...";
 	int sockfd, servlen,n;
@@ -63,21 +77,53 @@ int main (int argc, char *argv[])
 		std::cerr << "Error in connecting to the console... exiting.\n";
 		exit(1);
 	}
+	bzero(socket_buffer, SOCKET_BUFFER_SIZE);
+	sprintf(socket_buffer, "i%u,%u,%u,%u", sample_rate, period_size, source->buffer_size, nr_channels);
+	write(sockfd, socket_buffer, strlen(socket_buffer));
+	readbytes = read(sockfd, socket_buffer, SOCKET_BUFFER_SIZE-2);
+	if (readbytes < 1) {
+		std::cerr << "Error in connecting to the console... exiting.\n";
+		exit(1);
+	}
 	std::cerr << " done.\n";
 
 	int pid;
 	std::cerr << "Setting up oscilloscope display...";
-	std::vector<double>			txy(3, 0.0);
 	std::vector< std::vector<double> >	gnuplot_data;
-	std::vector<double>			xy(2, 0.0);
-	std::deque< std::vector<double> >	trigger_data;
-	std::deque< std::vector<double> >	sr;
-	std::deque< std::vector<double> >	accumulator_ch1;
-	std::deque< std::vector<double> >	accumulator_ch2;
-	std::vector<double>			aux_double_vec;
-	std::string				string_voltmeter_1, string_voltmeter_2;
+	double					zero_scaling[MAX_CHANNELS];
+	TraceBuffer				trigger_data;
+	TraceBuffer				waveform_data;
+	LogicDetector				logic;
+	LogicTrace				logic_trace;
+	ProtocolDecoder				decoder;
+	oXs_decoder_init(&decoder, decoder_output);
+	std::vector<std::string>		decoder_labels;
+	WaveformAverage average;
+	oXs_average_reset(&average, AVG_RUNNING, nr_channels, 1, 1);
+	WaveformEnvelope envelope;
+	oXs_envelope_reset(&envelope, nr_channels, 1, 1);
+	Voltmeter				voltmeter;
+	WaveformMeasure				measure;
+	oXs_measure_reset(&measure, nr_channels, 1.0 / (double) sample_rate);
+	std::vector<std::string>		measure_labels;
+	std::vector<std::string>		voltmeter_labels;
+	Spectrum				spectrum;
+	spectrum.plan.size = 0;
+	spectrum.size = 0;
+	unsigned int				spectrum_pending = 0;
+	Waterfall				waterfall;
+	BodeSweep				bode;
+	oXs_bode_init(&bode);
+	std::vector<std::string>		bode_labels;
+	bool					bode_update = false;
 	ScopeParameters*			scope_parameters = (ScopeParameters *) malloc(sizeof(ScopeParameters));
 	oXs_default_scope_parameters(scope_parameters);
+	scope_parameters->nr_channels = nr_channels;
+	scope_parameters->sample_rate = sample_rate;
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++)
+		zero_scaling[c] = 0.0;
+	oXs_trace_buffer_init(&trigger_data, nr_channels);
+	oXs_trace_buffer_init(&waveform_data, nr_channels);
 	FILE*	gnuplot_pipe;
 	char*	gnuplot_fifo = (char *) malloc(sizeof(char) * 64);
 	char*	clean_fifo = (char *) malloc(sizeof(char) * 64);
@@ -91,214 +137,398 @@ int main (int argc, char *argv[])
 	oXs_setup_gnuplot_analog_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
 	std::cerr << " done.\n";
 
-	std::cerr << "Oscilloscope running.\n";
+	std::cerr << "Oscilloscope running (trigger search: " << oXs_crossing_kernel_name(oXs_select_crossing_kernel()) << ").\n";
+	std::chrono::steady_clock::time_point run_start = std::chrono::steady_clock::now();
 	double dt = 1.0 / (double) sample_rate;
-	double t = 0.0;
-	int niter = 0, ntrig = 0;
-	bool triggered = false;
+	int niter = 0;
+	unsigned long reported_xruns = 0, reported_overruns = 0;
+	TriggerScan scan;
+	oXs_trigger_scan_init(&scan);
+	TriggerMachine trigger;
+	oXs_trigger_machine_init(&trigger);
+	RollDisplay roll;
+	bool restart_acquisition = true;
+	double waveform_rate = 0.0;
+	unsigned long rate_completed = 0;
+	std::chrono::steady_clock::time_point rate_start = run_start;
 	bool pause_command = false;
+	bool single_armed = true;
+	bool reposition = false;
+	trigger_status sweep_status = STATUS_TRIGGERED;
+	std::chrono::steady_clock::time_point last_display = run_start;
 	osc_mode operation_mode = MODE_ANALOG;
 	while(!requested_termination) {
 		int trace_size = ceil(scope_parameters->tdiv * HORIZ_DIVS * sample_rate);
 		int nr_of_averages = scope_parameters->navg;
-		triggered = false;
-		trigger_data.clear();
-
-		if (!pause_command) {
-			if (operation_mode == MODE_ANALOG) {
-				while (trigger_data.size() < trace_size / 2) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; (j < BUF_SIZE * CHN_SIZE); j = j + CHN_SIZE) {
-						xy[0] = buf[j];
-						xy[1] = buf[j+1];
-						trigger_data.push_back(xy);
-						if (trigger_data.size() > trace_size / 2)
-							trigger_data.pop_front();
-					}
+		sweep_mode sweep = scope_parameters->trig_sweep;
+		bool refresh_display = true;
+		bool rolling = (operation_mode == MODE_ANALOG) && (scope_parameters->tdiv >= ROLL_MIN_TDIV);
+		bool streaming = ((operation_mode == MODE_ANALOG) && !rolling) || (operation_mode == MODE_DIGITAL);
+		if (pause_command) {
+			oXs_trace_buffer_reserve(&trigger_data, trace_size);
+			oXs_trace_buffer_clear(&trigger_data);
+			restart_acquisition = true;
+		} else if (restart_acquisition) {
+			if (streaming) {
+				// The history spans two whole waveforms, so that the latest
+				// one can be cut again with the trigger point anywhere
+				// within it, plus the samples that may follow it within the
+				// same period and a gap marker. Logic levels are kept as
+				// edge lists instead of samples.
+				if (operation_mode == MODE_ANALOG) {
+					oXs_trace_buffer_reserve(&trigger_data, 2 * trace_size + 2 * period_size);
+					oXs_trace_buffer_reserve(&waveform_data, trace_size);
+					oXs_trace_buffer_clear(&waveform_data);
+					oXs_average_reset(&average, scope_parameters->avg_mode, nr_channels, trace_size, nr_of_averages);
+					oXs_envelope_reset(&envelope, nr_channels, trace_size, (scope_parameters->acq_mode != ACQ_ENVELOPE)? 1 : ((nr_of_averages > 1)? nr_of_averages : 0));
+					oXs_measure_reset(&measure, nr_channels, dt);
+					measure_labels.clear();
 				}
+				oXs_trigger_scan_reset(&scan, trace_size, oXs_pre_trigger(scope_parameters, trace_size, sample_rate), lround(scope_parameters->trig_holdoff * sample_rate));
+				if (operation_mode == MODE_DIGITAL) {
+					oXs_logic_detector_reset(&logic, nr_channels, scope_parameters->dig_window, scope_parameters->dig_threshold);
+					oXs_logic_trace_reset(&logic_trace, nr_channels, 2 * trace_size + 2 * period_size);
+					oXs_decoder_reset(&decoder, scope_parameters->dec_type, scope_parameters->dec_channel, nr_channels, sample_rate / scope_parameters->dec_baud, 2 * trace_size + 2 * period_size);
+				} else {
+					oXs_setup_trigger_machine(&trigger, scope_parameters, sample_rate);
+				}
+			} else if (rolling) {
+				oXs_roll_display_reset(&roll, nr_channels, trace_size, dt, scope_parameters->tdiv, scope_parameters->y_vps);
+			} else if (operation_mode == MODE_SPECTRUM) {
+				// The record is the largest power of two that fits in the
+				// trace, copied out of the history for each transform.
+				unsigned int record_size = oXs_spectrum_size(trace_size);
+				oXs_trace_buffer_reserve(&trigger_data, record_size);
+				oXs_trace_buffer_reserve(&waveform_data, record_size);
+				oXs_spectrum_reset(&spectrum, nr_channels, record_size, scope_parameters->spec_window, scope_parameters->spec_averaging, nr_of_averages);
+				spectrum_pending = 0;
+			} else if (operation_mode == MODE_WATERFALL) {
+				unsigned int c = scope_parameters->trig_chan - 1;
+				oXs_waterfall_reset(&waterfall, c, oXs_waterfall_size(trace_size), scope_parameters->spec_window, scope_parameters->y_vps[c], sample_rate);
+			} else if (operation_mode == MODE_BODE) {
+				oXs_bode_reset(&bode, sample_rate, scope_parameters->bode_start, scope_parameters->bode_stop, scope_parameters->bode_points, scope_parameters->y_vps[1] / scope_parameters->y_vps[0]);
+				bode_update = true;
+			} else {
+				oXs_trace_buffer_reserve(&trigger_data, trace_size);
+				if (operation_mode == MODE_VOLTMETER)
+					oXs_voltmeter_reset(&voltmeter, nr_channels, sample_rate, scope_parameters->vm_interval);
+			}
+			oXs_trace_buffer_clear(&trigger_data);
+			restart_acquisition = false;
+		}
 
-				ntrig = 0;
-				while (!triggered) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; ((j < BUF_SIZE * CHN_SIZE) && (trigger_data.size() < trace_size)); j = j + CHN_SIZE) {
-						xy[0] = buf[j];
-						xy[1] = buf[j+1];
-						if (!triggered && !oXs_trigger_crossing(trigger_data, xy, scope_parameters)) {
-							trigger_data.pop_front();
+		if (!pause_command) {
+			if (rolling) {
+				do {
+					oXs_capture_next_block(&capture, &block);
+					oXs_roll_display_push_block(&roll, &block);
+				} while (oXs_capture_available(&capture) >= period_size);
+			} else if (streaming) {
+				// Every captured sample goes through the trigger scan. The
+				// display is refreshed once the capture ring is drained, if
+				// a new waveform has been completed meanwhile; in auto
+				// sweeps, also after a whole trace without any trigger, if
+				// the auto timeout has expired since the last display.
+				// Otherwise, the loop sleeps on the capture ring. Either
+				// way, it goes back to the console after at most
+				// TRIGGER_POLL_INTERVAL, even if the ring never drains.
+				// Waveforms are copied out of the history only when
+				// averaged, enveloped or measured; otherwise, only the
+				// latest one of each period is (in single sweeps, the
+				// first one), and in peak-detect mode it is reduced to
+				// column extrema when displayed. Waveforms with a gap are
+				// displayed, but not averaged. When the trigger point has
+				// been moved, the latest waveform is cut again out of the
+				// history, if it is still there. In digital mode, the
+				// history is the edge list, where triggers are searched
+				// and whence the window ending at window_end is displayed.
+				// Measurements are averaged over the waveforms acquired
+				// between two displays.
+				acquisition_mode acquisition = (operation_mode == MODE_ANALOG)? scope_parameters->acq_mode : ACQ_SAMPLE;
+				bool averaging = (acquisition == ACQ_SAMPLE) && (operation_mode == MODE_ANALOG) && (nr_of_averages > 1);
+				bool accumulating = averaging || (acquisition == ACQ_ENVELOPE);
+				bool measuring = (operation_mode == MODE_ANALOG) && scope_parameters->measure;
+				unsigned long completed_before = scan.completed;
+				unsigned long copied_end = scan.latest_end;
+				unsigned long window_end = scan.latest_end;
+				float display_fraction = 0.0;
+				unsigned long nr_scanned = 0;
+				bool display = false;
+				std::chrono::steady_clock::time_point sweep_start = std::chrono::steady_clock::now();
+				if ((sweep == SWEEP_SINGLE) && !single_armed) {
+					// The shot has been taken: the history goes on until
+					// it holds whatever the trigger point may be moved
+					// to, then periods are discarded until re-armed.
+					unsigned long freeze = scan.latest_trigger + trace_size + lround(scope_parameters->trig_delay * sample_rate);
+					while (oXs_capture_available(&capture) >= period_size) {
+						oXs_capture_next_block(&capture, &block);
+						if (scan.position >= freeze)
+							continue;
+						if (block.gap_frames > 0)
+							oXs_trigger_scan_advance(&scan, 1);
+						if (operation_mode == MODE_DIGITAL) {
+							oXs_logic_detector_process(&logic, &block, &levels);
+							oXs_logic_trace_push_period(&logic_trace, &levels);
+							oXs_decoder_push_period(&decoder, &levels);
 						} else {
-							triggered = true;
+							if (block.gap_frames > 0)
+								oXs_trace_buffer_push_gap(&trigger_data);
+							oXs_trace_buffer_push_period(&trigger_data, &block);
 						}
-						trigger_data.push_back(xy);
-						ntrig++;
+						oXs_trigger_scan_advance(&scan, block.size);
 					}
-					if (ntrig > 1.0 * trace_size) {
-						std::cerr << "Trigger? (graphing anyway...)\n";
+					if (!reposition)
+						oXs_capture_wait(&capture, TRIGGER_POLL_INTERVAL);
+				}
+				while (single_armed || (sweep != SWEEP_SINGLE)) {
+					double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - sweep_start).count();
+					if (elapsed >= TRIGGER_POLL_INTERVAL)
 						break;
+					if (oXs_capture_available(&capture) < period_size) {
+						if (display || reposition)
+							break;
+						oXs_capture_wait(&capture, TRIGGER_POLL_INTERVAL - elapsed);
+						continue;
 					}
-				}
-
-				while (trigger_data.size() < trace_size) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; ((j < BUF_SIZE * CHN_SIZE) && (trigger_data.size() < trace_size)); j = j + CHN_SIZE) {
-						xy[0] = buf[j];
-						xy[1] = buf[j+1];
-						trigger_data.push_back(xy);
+					oXs_capture_next_block(&capture, &block);
+					// The gap marker takes one position; a waveform it
+					// completes is collected with those of the block.
+					if (block.gap_frames > 0)
+						oXs_trigger_scan_advance(&scan, 1);
+					// In digital mode, the period is first converted into
+					// logic levels, appended to the edge list, where
+					// triggers are the edges of the trigger channel, and
+					// fed to the protocol decoder.
+					// Otherwise, triggers are searched block-wise by the
+					// trigger state machine, before the block is pushed.
+					if (operation_mode == MODE_DIGITAL) {
+						oXs_logic_detector_process(&logic, &block, &levels);
+						oXs_logic_trace_push_period(&logic_trace, &levels);
+						oXs_decoder_push_period(&decoder, &levels);
+						unsigned long block_start = logic_trace.position - levels.size;
+						long edge = block_start;
+						while ((edge = oXs_logic_trace_next_edge(&logic_trace, scope_parameters->trig_chan - 1, edge, scope_parameters->trig_rising_edge)) >= 0) {
+							oXs_trigger_scan_arm(&scan, edge - block_start, 0.0);
+							edge++;
+						}
+					} else {
+						const float* x = block.samples[scope_parameters->trig_chan - 1];
+						if (block.gap_frames > 0) {
+							oXs_trace_buffer_push_gap(&trigger_data);
+							oXs_trigger_machine_reset(&trigger);
+						}
+						unsigned int j = 0;
+						int k;
+						while ((j < block.size) && ((k = oXs_trigger_machine_find(&trigger, x + j, block.size - j)) >= 0)) {
+							oXs_trigger_scan_arm(&scan, j + k, trigger.fraction);
+							j += k + 1;
+						}
+						oXs_trace_buffer_push_period(&trigger_data, &block);
 					}
-				}
-
-				if (nr_of_averages > 1) {
-					aux_double_vec.clear();
-					for (int j = 0; j < trigger_data.size(); j++)
-						aux_double_vec.push_back(trigger_data[j][0] * scope_parameters->y1_vps);
-					accumulator_ch1.push_back(aux_double_vec);
-					if (accumulator_ch1.size() > nr_of_averages)
-						accumulator_ch1.pop_front();
-
-					aux_double_vec.clear();
-					for (int j = 0; j < trigger_data.size(); j++)
-						aux_double_vec.push_back(trigger_data[j][1] * scope_parameters->y2_vps);
-					accumulator_ch2.push_back(aux_double_vec);
-					if (accumulator_ch2.size() > nr_of_averages)
-						accumulator_ch2.pop_front();
-
-					gnuplot_data.clear();
-					t = -0.5*trigger_data.size()*dt;
-					for (int j = 0; j < trigger_data.size(); j++) {
-						txy[0] = t;
-						txy[1] = 0.0;
-						for (int i = 0; i < accumulator_ch1.size(); i++)
-							txy[1] += accumulator_ch1[i][j] / (double) accumulator_ch1.size();
-						txy[2] = 0.0;
-						for (int i = 0; i < accumulator_ch2.size(); i++)
-							txy[2] += accumulator_ch2[i][j] / (double) accumulator_ch2.size();
-						gnuplot_data.push_back(txy);
-						t += dt;
+					oXs_trigger_scan_advance(&scan, block.size);
+					while (oXs_trigger_scan_complete(&scan)) {
+						if (accumulating || measuring) {
+							oXs_trace_buffer_copy_window(&waveform_data, &trigger_data, trace_size, scan.position - scan.latest_end);
+							if (averaging)
+								oXs_average_add(&average, &waveform_data, scope_parameters->y_vps, scan.latest_fraction);
+							else if (accumulating)
+								oXs_envelope_add(&envelope, &waveform_data);
+							if (measuring)
+								oXs_measure_add(&measure, &waveform_data);
+							copied_end = scan.latest_end;
+						}
+						if (sweep == SWEEP_SINGLE)
+							oXs_trigger_scan_stop(&scan);
 					}
-				} else {
-					gnuplot_data.clear();
-					t = -0.5*trigger_data.size()*dt;
-					for (int j = 0; j < trigger_data.size(); j++) {
-						txy[0] = t;
-						txy[1] = trigger_data[j][0] * scope_parameters->y1_vps;
-						txy[2] = trigger_data[j][1] * scope_parameters->y2_vps;
-						gnuplot_data.push_back(txy);
-						t += dt;
+					if (scan.latest_end != copied_end) {
+						if (operation_mode == MODE_ANALOG)
+							oXs_trace_buffer_copy_window(&waveform_data, &trigger_data, trace_size, scan.position - scan.latest_end);
+						copied_end = scan.latest_end;
+						window_end = scan.latest_end;
+						display_fraction = scan.latest_fraction;
 					}
-				}
-
-			} else if (operation_mode == MODE_XY) {
-				while (trigger_data.size() < trace_size) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; (j < BUF_SIZE * CHN_SIZE); j = j + CHN_SIZE) {
-						xy[0] = buf[j];
-						xy[1] = buf[j+1];
-						trigger_data.push_back(xy);
-						if (trigger_data.size() > trace_size)
-							trigger_data.pop_front();
+					nr_scanned += block.size;
+					if (scan.completed != completed_before) {
+						display = true;
+						if (sweep == SWEEP_SINGLE)
+							break;
+					} else if ((sweep == SWEEP_AUTO) && (nr_scanned >= trace_size) && (scan.pending_count == 0)) {
+						std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+						display = (std::chrono::duration<double>(now - last_display).count() >= scope_parameters->trig_auto_timeout);
 					}
 				}
-				gnuplot_data.clear();
-				t = -0.5*trigger_data.size()*dt;
-				for (int j = 0; j < trigger_data.size(); j++) {
-					txy[0] = t;
-					txy[1] = trigger_data[j][0] * scope_parameters->y1_vps;
-					txy[2] = trigger_data[j][1] * scope_parameters->y2_vps;
-					gnuplot_data.push_back(txy);
-					t += dt;
-				}
-			} else if (operation_mode == MODE_DIGITAL) {
-				while (trigger_data.size() < trace_size / 2) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; (j < BUF_SIZE * CHN_SIZE); j = j + CHN_SIZE) {
-						oXs_digital_acquisition(xy, sr, buf, j);
-						trigger_data.push_back(xy);
-						if (trigger_data.size() > trace_size / 2)
-							trigger_data.pop_front();
-					}
+				if (scan.completed != completed_before) {
+					sweep_status = STATUS_TRIGGERED;
+					if (sweep == SWEEP_SINGLE)
+						single_armed = false;
+				} else if (display) {
+					std::cerr << "Trigger? (graphing anyway...)\n";
+					if (operation_mode == MODE_ANALOG)
+						oXs_trace_buffer_copy_window(&waveform_data, &trigger_data, trace_size, 0);
+					window_end = scan.position;
+					if (averaging)
+						oXs_average_add(&average, &waveform_data, scope_parameters->y_vps, 0.0);
+					else if (acquisition == ACQ_ENVELOPE)
+						oXs_envelope_add(&envelope, &waveform_data);
+					if (measuring)
+						oXs_measure_add(&measure, &waveform_data);
+					sweep_status = STATUS_TRIGGERED;
+				} else if (reposition && oXs_trigger_scan_recut(&scan, (operation_mode == MODE_DIGITAL)? std::min(logic_trace.position, logic_trace.span) : trigger_data.count)) {
+					if (operation_mode == MODE_ANALOG)
+						oXs_trace_buffer_copy_window(&waveform_data, &trigger_data, trace_size, scan.position - scan.latest_end);
+					window_end = scan.latest_end;
+					display_fraction = scan.latest_fraction;
+					if (averaging)
+						oXs_average_add(&average, &waveform_data, scope_parameters->y_vps, display_fraction);
+					else if (acquisition == ACQ_ENVELOPE)
+						oXs_envelope_add(&envelope, &waveform_data);
+					if (measuring)
+						oXs_measure_add(&measure, &waveform_data);
+				} else {
+					refresh_display = false;
+					if (sweep != SWEEP_SINGLE)
+						sweep_status = STATUS_WAITING;
+					else
+						sweep_status = (single_armed)? STATUS_ARMED : STATUS_STOPPED;
 				}
-
-				ntrig = 0;
-				while (!triggered) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; ((j < BUF_SIZE * CHN_SIZE) && (trigger_data.size() < trace_size)); j = j + CHN_SIZE) {
-						oXs_digital_acquisition(xy, sr, buf, j);
-						if (!triggered && !oXs_trigger_digital(trigger_data, xy, scope_parameters)) {
-							trigger_data.pop_front();
-						} else {
-							triggered = true;
-						}
-						trigger_data.push_back(xy);
-						ntrig++;
+				if (display)
+					last_display = std::chrono::steady_clock::now();
+				reposition = false;
+
+				if (refresh_display) {
+					double origin = display_fraction - scan.pre_trigger;
+					if (measuring && (measure.count > 0)) {
+						oXs_measure_read(&measure);
+						oXs_measure_labels(&measure, measure_labels);
 					}
-					if (ntrig > 1.0 * trace_size) {
-						std::cerr << "Trigger? [graphing anyway...]\n";
-						break;
+					if (operation_mode == MODE_DIGITAL) {
+						unsigned long start = (window_end > trace_size)? window_end - trace_size : 0;
+						oXs_logic_trace_fill(&logic_trace, gnuplot_data, start, trace_size, dt, origin);
+						oXs_decoder_labels(&decoder, decoder_labels, start, trace_size, dt, origin);
+					} else if (averaging && (average.count > 0)) {
+						oXs_fill_gnuplot_data(gnuplot_data, &waveform_data, dt, zero_scaling, 1, -scan.pre_trigger);
+						oXs_average_fill(&average, gnuplot_data);
+					} else if ((acquisition == ACQ_PEAK_DETECT) && oXs_envelope_add(&envelope, &waveform_data)) {
+						oXs_envelope_fill(&envelope, gnuplot_data, dt, scope_parameters->y_vps, origin);
+					} else if ((acquisition == ACQ_ENVELOPE) && (envelope.count > 0)) {
+						oXs_envelope_fill(&envelope, gnuplot_data, dt, scope_parameters->y_vps, -scan.pre_trigger);
+					} else {
+						oXs_fill_gnuplot_data(gnuplot_data, &waveform_data, dt, scope_parameters->y_vps, 1, origin);
 					}
 				}
 
-				while (trigger_data.size() < trace_size) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; ((j < BUF_SIZE * CHN_SIZE) && (trigger_data.size() < trace_size)); j = j + CHN_SIZE) {
-						oXs_digital_acquisition(xy, sr, buf, j);
-						trigger_data.push_back(xy);
-					}
-				}
-
-				gnuplot_data.clear();
-				t = -0.5*trigger_data.size()*dt;
-				for (int j = 0; j < trigger_data.size(); j++) {
-					txy[0] = t;
-					txy[1] = trigger_data[j][0];
-					txy[2] = trigger_data[j][1];
-					gnuplot_data.push_back(txy);
-					t += dt;
-				}
 			} else if (operation_mode == MODE_VOLTMETER) {
-				while (trigger_data.size() < trace_size) {
-					snd_pcm_readi(device_handle, buf, BUF_SIZE);
-					for (int j = 0; (j < BUF_SIZE * CHN_SIZE); j = j + CHN_SIZE) {
-						xy[0] = buf[j];
-						xy[1] = buf[j+1];
-						trigger_data.push_back(xy);
-						if (trigger_data.size() > trace_size)
-							trigger_data.pop_front();
-					}
+				// Every period goes through the voltmeter; the labels are
+				// refreshed whenever a reading is completed, the traces
+				// being flat lines.
+				bool reading = false;
+				do {
+					oXs_capture_next_block(&capture, &block);
+					if (oXs_voltmeter_push_period(&voltmeter, &block))
+						reading = true;
+				} while (oXs_capture_available(&capture) >= period_size);
+				if (reading) {
+					oXs_voltmeter_labels(&voltmeter, voltmeter_labels, scope_parameters->y_vps);
+					gnuplot_data.assign(2, std::vector<double>(nr_channels + 1, 0.0));
+					gnuplot_data[0][0] = -0.5 * trace_size * dt;
+					gnuplot_data[1][0] = 0.5 * trace_size * dt;
+				} else {
+					refresh_display = false;
 				}
-				gnuplot_data.clear();
-				t = -0.5*trigger_data.size()*dt;
-				for (int j = 0; j < trigger_data.size(); j++) {
-					txy[0] = t;
-					txy[1] = 0.0;
-					txy[2] = 0.0;
-					gnuplot_data.push_back(txy);
-					t += dt;
+			} else if (operation_mode == MODE_SPECTRUM) {
+				// A spectrum of the latest record is taken once enough new
+				// samples have arrived: a whole record, or 1/SPECTRUM_MAX_RATE
+				// of a second if shorter, so that long records overlap and
+				// the transforms never outpace the display. Gaps restart
+				// the record.
+				do {
+					oXs_capture_next_block(&capture, &block);
+					if (block.gap_frames > 0)
+						oXs_trace_buffer_clear(&trigger_data);
+					oXs_trace_buffer_push_period(&trigger_data, &block);
+					spectrum_pending += block.size;
+				} while (oXs_capture_available(&capture) >= period_size);
+				unsigned int spectrum_interval = std::min(spectrum.size, (unsigned int) (sample_rate / SPECTRUM_MAX_RATE));
+				if ((trigger_data.count >= spectrum.size) && (spectrum_pending >= spectrum_interval)) {
+					oXs_trace_buffer_copy_window(&waveform_data, &trigger_data, spectrum.size, 0);
+					oXs_spectrum_add(&spectrum, &waveform_data);
+					oXs_spectrum_fill(&spectrum, gnuplot_data, sample_rate, scope_parameters->spec_scale, scope_parameters->y_vps);
+					spectrum_pending = 0;
+				} else {
+					refresh_display = false;
 				}
-				oXs_voltmeter_acquisition(string_voltmeter_1, string_voltmeter_2, trigger_data, scope_parameters);
+			} else if (operation_mode == MODE_WATERFALL) {
+				// Columns of the spectrogram are computed as the samples
+				// arrive; the image is redrawn whenever new ones have been
+				// added.
+				unsigned int added = 0;
+				do {
+					oXs_capture_next_block(&capture, &block);
+					added += oXs_waterfall_push_period(&waterfall, &block);
+				} while (oXs_capture_available(&capture) >= period_size);
+				if (added == 0)
+					refresh_display = false;
+			} else if (operation_mode == MODE_BODE) {
+				// Points are measured as the samples arrive; the plot is
+				// redrawn whenever one is taken, and when the generator
+				// starts or stops listening.
+				bool sent = bode.sent, taken = false;
+				do {
+					oXs_capture_next_block(&capture, &block);
+					if (oXs_bode_push_period(&bode, &block))
+						taken = true;
+				} while (oXs_capture_available(&capture) >= period_size);
+				if (taken || (bode.sent != sent) || bode_update) {
+					oXs_bode_fill(&bode, gnuplot_data);
+					oXs_bode_labels(&bode, bode_labels);
+					bode_update = false;
+				} else {
+					refresh_display = false;
+				}
+			} else {
+				// XY mode shows the most recent trace_size samples,
+				// refreshed as soon as new periods arrive; at slow time
+				// scales, points are thinned out.
+				do {
+					oXs_capture_next_block(&capture, &block);
+					if (block.gap_frames > 0)
+						oXs_trace_buffer_clear(&trigger_data);
+					for (int j = 0; (j < block.size); j++)
+						oXs_trace_buffer_push_block(&trigger_data, &block, j);
+				} while (oXs_capture_available(&capture) >= period_size);
+				unsigned int stride = 1 + trigger_data.count / XY_MAX_POINTS;
+				double origin = -(double) (trigger_data.count / 2);
+				oXs_fill_gnuplot_data(gnuplot_data, &trigger_data, dt, scope_parameters->y_vps, stride, origin);
 			}
 		} else {
-			while (trigger_data.size() < ((trace_size > 4410)? 4410 : trace_size)) {
-				snd_pcm_readi(device_handle, buf, BUF_SIZE);
-				for (int j = 0; (j < BUF_SIZE * CHN_SIZE); j = j + CHN_SIZE) {
-					xy[0] = buf[j];
-					xy[1] = buf[j+1];
-					trigger_data.push_back(xy);
-				}
+			while (trigger_data.count < ((trace_size > sample_rate / 10)? sample_rate / 10 : trace_size)) {
+				oXs_capture_next_block(&capture, &block);
+				for (int j = 0; (j < block.size); j++)
+					oXs_trace_buffer_push_block(&trigger_data, &block, j);
 			}
 		}
 
-		if (!pause_command) {
+		if (!pause_command && refresh_display) {
+			if (streaming) {
+				const std::vector<std::string> & labels = (operation_mode == MODE_DIGITAL)? decoder_labels : measure_labels;
+				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", "label", gnuplot_data);
+				for (unsigned int c = 0; c < labels.size(); c++)
+					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", labels[c].c_str(), gnuplot_data);
+			}
 			if (niter % REFRESH_GP == 0) {
-				if (operation_mode == MODE_ANALOG) {
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 1:2 axis x1y1 w l lw 3 lc rgb 'yellow', \"\" u 1:3 axis x1y2 w l lw 3 lc rgb 'cyan'", gnuplot_data);
-				} else if (operation_mode == MODE_XY) {
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 2:3 w l lw 2 lc rgb 'magenta'", gnuplot_data);
-				} else if (operation_mode == MODE_DIGITAL) {
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 1:($2+1.2) axis x1y1 w l lw 3 lc rgb 'yellow', \"\" u 1:3 axis x1y2 w l lw 3 lc rgb 'cyan'", gnuplot_data);
-				} else if (operation_mode == MODE_VOLTMETER) {
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", string_voltmeter_1.c_str(), gnuplot_data);
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", string_voltmeter_2.c_str(), gnuplot_data);
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 1:2 axis x1y1 w l lw 3 lc rgb 'yellow', \"\" u 1:3 axis x1y2 w l lw 3 lc rgb 'cyan'", gnuplot_data);
+				if (operation_mode == MODE_VOLTMETER) {
+					for (unsigned int c = 0; c < voltmeter_labels.size(); c++)
+						GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", voltmeter_labels[c].c_str(), gnuplot_data);
+				} else if (operation_mode == MODE_BODE) {
+					for (unsigned int c = 0; c < bode_labels.size(); c++)
+						GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", bode_labels[c].c_str(), gnuplot_data);
 				}
+				if (rolling)
+					oXs_roll_display_plot(gnuplot_pipe, &roll, oXs_plot_command(operation_mode, scope_parameters));
+				else if (operation_mode == MODE_WATERFALL)
+					oXs_waterfall_plot(gnuplot_pipe, gnuplot_fifo, &waterfall);
+				else
+					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", oXs_plot_command(operation_mode, scope_parameters).c_str(), gnuplot_data);
 				usleep(10000);
 				niter = 0;
 			} else if (niter % REFRESH_GP == (REFRESH_GP - 1)){
@@ -315,27 +545,62 @@ int main (int argc, char *argv[])
 					oXs_setup_gnuplot_digital_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
 				} else if (operation_mode == MODE_VOLTMETER) {
 					oXs_setup_gnuplot_voltmeter_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+				} else if (operation_mode == MODE_SPECTRUM) {
+					oXs_setup_gnuplot_spectrum_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+				} else if (operation_mode == MODE_WATERFALL) {
+					oXs_setup_gnuplot_waterfall_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+				} else if (operation_mode == MODE_BODE) {
+					oXs_setup_gnuplot_bode_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
 				}
 				usleep(10000);
 			} else {
 				if (operation_mode == MODE_VOLTMETER) {
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", string_voltmeter_1.c_str(), gnuplot_data);
-					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", string_voltmeter_2.c_str(), gnuplot_data);
+					for (unsigned int c = 0; c < voltmeter_labels.size(); c++)
+						GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", voltmeter_labels[c].c_str(), gnuplot_data);
 					if (niter < (REFRESH_GP - 250))
 						niter = REFRESH_GP - 250;
+				} else if (operation_mode == MODE_BODE) {
+					for (unsigned int c = 0; c < bode_labels.size(); c++)
+						GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", bode_labels[c].c_str(), gnuplot_data);
 				}
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "refresh", "", gnuplot_data);
+				if (rolling)
+					oXs_roll_display_refresh(gnuplot_pipe, &roll);
+				else if (operation_mode == MODE_WATERFALL)
+					oXs_waterfall_plot(gnuplot_pipe, gnuplot_fifo, &waterfall);
+				else
+					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "refresh", "", gnuplot_data);
 				usleep(10000);
 			}
-		} else {
+		} else if (pause_command) {
 			usleep(10000);
 		}
 
+		if (capture.xruns.load() != reported_xruns) {
+			reported_xruns = capture.xruns.load();
+			std::cerr << "Device overrun: " << capture.lost_frames.load() << " frames lost so far in " << reported_xruns << " overruns.\n";
+		}
+		if (capture.overruns.load() != reported_overruns) {
+			reported_overruns = capture.overruns.load();
+			std::cerr << "Capture ring overrun: " << capture.dropped_frames.load() << " frames dropped so far (ring high-water mark " << capture.high_water.load() << "/" << capture.ring.capacity << ").\n";
+		}
+
+		std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+		double rate_interval = std::chrono::duration<double>(now - rate_start).count();
+		if (rate_interval >= 1.0) {
+			waveform_rate = (scan.completed - rate_completed) / rate_interval;
+			rate_completed = scan.completed;
+			rate_start = now;
+		}
+
 		if (requested_termination)
 			break;
 		bzero(socket_buffer, SOCKET_BUFFER_SIZE);
-		socket_buffer[0] = 'g';
-		socket_buffer[1] = '\0';
+		sprintf(socket_buffer, "g%lu,%lu,%lu,%lu,%.0f,%u", capture.xruns.load(), capture.lost_frames.load(), capture.overruns.load(), capture.dropped_frames.load(), waveform_rate, (streaming)? sweep_status : STATUS_TRIGGERED);
+		if (streaming && (operation_mode == MODE_ANALOG) && scope_parameters->measure) {
+			const double* m1 = measure.value[0];
+			const double* m2 = measure.value[1];
+			sprintf(socket_buffer + strlen(socket_buffer), ",%.4e,%.4e,%.4e,%.4e,%.4e,%.4e,%.4e,%.4e", m1[MEAS_FREQUENCY], m1[MEAS_DUTY], m1[MEAS_RISE], m1[MEAS_FALL], m1[MEAS_OVERSHOOT], m2[MEAS_DELAY], m2[MEAS_PHASE], m1[MEAS_PERIOD]);
+		}
 		write(sockfd, socket_buffer, strlen(socket_buffer));
 		readbytes = read(sockfd, socket_buffer, SOCKET_BUFFER_SIZE-2);
 		if (readbytes < 1) {
@@ -357,17 +622,29 @@ int main (int argc, char *argv[])
 			std::string msg_navg = socket_buffer_msg.substr(41, 3);
 
 			scope_parameters->tdiv = atof(msg_tdiv.c_str());
-			scope_parameters->y1div = atof(msg_y1div.c_str());
-			scope_parameters->y2div = atof(msg_y2div.c_str());
+			scope_parameters->ydiv[0] = atof(msg_y1div.c_str());
+			scope_parameters->ydiv[1] = atof(msg_y2div.c_str());
 			scope_parameters->trig_rising_edge = (msg_tredge == "r")? true : false;
 			scope_parameters->trig_chan = atoi(msg_trchan.c_str());
+			if ((scope_parameters->trig_chan < 1) || (scope_parameters->trig_chan > nr_channels))
+				scope_parameters->trig_chan = 1;
 			scope_parameters->trig_level = atof(msg_trlevel.c_str());
-			scope_parameters->y1_vps = atof(msg_y1vps.c_str());
-			scope_parameters->y2_vps = atof(msg_y2vps.c_str());
+			scope_parameters->y_vps[0] = atof(msg_y1vps.c_str());
+			scope_parameters->y_vps[1] = atof(msg_y2vps.c_str());
 			scope_parameters->navg = atoi(msg_navg.c_str());
+			// Channels beyond the second one follow, 4 characters for the
+			// vertical scale and 9 for the calibration each.
+			for (unsigned int c = 2; c < nr_channels; c++) {
+				unsigned int offset = 44 + 13 * (c - 2);
+				if (socket_buffer_msg.size() < offset + 13)
+					break;
+				scope_parameters->ydiv[c] = atof(socket_buffer_msg.substr(offset, 4).c_str());
+				scope_parameters->y_vps[c] = atof(socket_buffer_msg.substr(offset + 4, 9).c_str());
+			}
 
-			accumulator_ch1.clear();
-			accumulator_ch2.clear();
+			oXs_average_clear(&average);
+			oXs_envelope_clear(&envelope);
+			restart_acquisition = true;
 			kill(-pid, 9);
 			pclose2(gnuplot_pipe, pid);
 			usleep(10000);
@@ -375,21 +652,138 @@ int main (int argc, char *argv[])
 			oXs_setup_oscilloscope_screen(gnuplot_pipe, gnuplot_fifo);
 			if (operation_mode == MODE_ANALOG) {
 				oXs_setup_gnuplot_analog_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 1:2 axis x1y1 w l lw 3 lc rgb 'yellow', \"\" u 1:3 axis x1y2 w l lw 3 lc rgb 'cyan'", gnuplot_data);
 			} else if (operation_mode == MODE_XY) {
 				oXs_setup_gnuplot_xy_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 2:3 w l lw 2 lc rgb 'magenta'", gnuplot_data);
 			} else if (operation_mode == MODE_DIGITAL) {
 				oXs_setup_gnuplot_digital_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 1:($2+1.2) axis x1y1 w l lw 3 lc rgb 'yellow', \"\" u 1:3 axis x1y2 w l lw 3 lc rgb 'cyan'", gnuplot_data);
 			} else if (operation_mode == MODE_VOLTMETER) {
 				oXs_setup_gnuplot_voltmeter_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", string_voltmeter_1.c_str(), gnuplot_data);
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", string_voltmeter_2.c_str(), gnuplot_data);
-				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", "u 1:($2+1.2) axis x1y1 w l lw 3 lc rgb 'yellow', \"\" u 1:3 axis x1y2 w l lw 3 lc rgb 'cyan'", gnuplot_data);
+				for (unsigned int c = 0; c < voltmeter_labels.size(); c++)
+					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", voltmeter_labels[c].c_str(), gnuplot_data);
+			} else if (operation_mode == MODE_SPECTRUM) {
+				oXs_setup_gnuplot_spectrum_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+			} else if (operation_mode == MODE_WATERFALL) {
+				oXs_setup_gnuplot_waterfall_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+			} else if (operation_mode == MODE_BODE) {
+				oXs_setup_gnuplot_bode_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+				for (unsigned int c = 0; c < bode_labels.size(); c++)
+					GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", bode_labels[c].c_str(), gnuplot_data);
 			}
+			if (operation_mode != MODE_WATERFALL)
+				GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "plot", oXs_plot_command(operation_mode, scope_parameters).c_str(), gnuplot_data);
 			usleep(10000);
 			pause_command = false;
+			niter = -1;
+		} else if (socket_buffer[0] == 't') {
+			unsigned int type, condition, sweep_setting;
+			double hysteresis, level_high, time_min, time_max, holdoff, auto_timeout;
+			if (sscanf(socket_buffer + 1, "%u,%u,%lf,%lf,%lf,%lf,%u,%lf,%lf", &type, &condition, &hysteresis, &level_high, &time_min, &time_max, &sweep_setting, &holdoff, &auto_timeout) == 9) {
+				scope_parameters->trig_type = (type <= TRIG_SLEW)? (trigger_type) type : TRIG_EDGE;
+				scope_parameters->trig_condition = (condition <= TRIG_BETWEEN)? (trigger_condition) condition : TRIG_LONGER;
+				scope_parameters->trig_hysteresis = hysteresis;
+				scope_parameters->trig_level_high = level_high;
+				scope_parameters->trig_time_min = time_min;
+				scope_parameters->trig_time_max = time_max;
+				scope_parameters->trig_sweep = (sweep_setting <= SWEEP_SINGLE)? (sweep_mode) sweep_setting : SWEEP_AUTO;
+				scope_parameters->trig_holdoff = (holdoff > 0.0)? holdoff : 0.0;
+				scope_parameters->trig_auto_timeout = (auto_timeout > 0.0)? auto_timeout : 0.0;
+				single_armed = true;
+				oXs_average_clear(&average);
+				oXs_envelope_clear(&envelope);
+				restart_acquisition = true;
+			} else {
+				std::cerr << "Communication error: malformed trigger settings...\n";
+			}
+		} else if (socket_buffer[0] == 'o') {
+			double position, delay;
+			if (sscanf(socket_buffer + 1, "%lf,%lf", &position, &delay) == 2) {
+				scope_parameters->trig_position = (position < 0.0)? 0.0 : ((position > 1.0)? 1.0 : position);
+				scope_parameters->trig_delay = (delay < 0.0)? 0.0 : ((delay > MAX_TRIGGER_DELAY)? MAX_TRIGGER_DELAY : delay);
+				oXs_trigger_scan_set_pre_trigger(&scan, oXs_pre_trigger(scope_parameters, trace_size, sample_rate));
+				oXs_average_clear(&average);
+				oXs_envelope_clear(&envelope);
+				reposition = true;
+				if (operation_mode == MODE_ANALOG)
+					oXs_setup_gnuplot_analog_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+				else if (operation_mode == MODE_DIGITAL)
+					oXs_setup_gnuplot_digital_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+			} else {
+				std::cerr << "Communication error: malformed trigger position...\n";
+			}
+		} else if (socket_buffer[0] == 'a') {
+			unsigned int mode, acquisition = ACQ_SAMPLE;
+			if (sscanf(socket_buffer + 1, "%u,%u", &mode, &acquisition) >= 1) {
+				scope_parameters->avg_mode = (mode <= AVG_EXPONENTIAL)? (average_mode) mode : AVG_RUNNING;
+				scope_parameters->acq_mode = (acquisition <= ACQ_ENVELOPE)? (acquisition_mode) acquisition : ACQ_SAMPLE;
+				restart_acquisition = true;
+			} else {
+				std::cerr << "Communication error: malformed averaging mode...\n";
+			}
+		} else if (socket_buffer[0] == 'l') {
+			unsigned int window;
+			double threshold;
+			if (sscanf(socket_buffer + 1, "%u,%lf", &window, &threshold) == 2) {
+				scope_parameters->dig_window = (window < 1)? 1 : ((window > DIG_SR_MAX_SIZE)? DIG_SR_MAX_SIZE : window);
+				scope_parameters->dig_threshold = (threshold > 0.0)? threshold : 0.0;
+				restart_acquisition = true;
+			} else {
+				std::cerr << "Communication error: malformed logic detection settings...\n";
+			}
+		} else if (socket_buffer[0] == 'k') {
+			unsigned int type, channel;
+			double baud;
+			if (sscanf(socket_buffer + 1, "%u,%u,%lf", &type, &channel, &baud) == 3) {
+				scope_parameters->dec_type = (type <= DEC_PULSE)? (decoder_type) type : DEC_NONE;
+				scope_parameters->dec_channel = (channel < nr_channels)? channel : 0;
+				scope_parameters->dec_baud = (baud > 0.0)? baud : DECODER_DEFAULT_BAUD;
+				restart_acquisition = true;
+			} else {
+				std::cerr << "Communication error: malformed decoder settings...\n";
+			}
+		} else if (socket_buffer[0] == 'v') {
+			double interval;
+			if (sscanf(socket_buffer + 1, "%lf", &interval) == 1) {
+				scope_parameters->vm_interval = (interval < VOLTMETER_MIN_INTERVAL)? VOLTMETER_MIN_INTERVAL : ((interval > VOLTMETER_MAX_INTERVAL)? VOLTMETER_MAX_INTERVAL : interval);
+				restart_acquisition = true;
+			} else {
+				std::cerr << "Communication error: malformed voltmeter settings...\n";
+			}
+		} else if (socket_buffer[0] == 'f') {
+			unsigned int window, scale, averaging;
+			if (sscanf(socket_buffer + 1, "%u,%u,%u", &window, &scale, &averaging) == 3) {
+				scope_parameters->spec_window = (window <= WIN_FLATTOP)? (spectrum_window) window : WIN_HANN;
+				scope_parameters->spec_scale = (scale <= SCALE_DB)? (spectrum_scale) scale : SCALE_DB;
+				scope_parameters->spec_averaging = (averaging <= SPEC_AVG_PEAK_HOLD)? (spectrum_averaging) averaging : SPEC_AVG_NONE;
+				restart_acquisition = true;
+				if (operation_mode == MODE_SPECTRUM)
+					oXs_setup_gnuplot_spectrum_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+				else if (operation_mode == MODE_WATERFALL)
+					oXs_setup_gnuplot_waterfall_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+			} else {
+				std::cerr << "Communication error: malformed spectrum settings...\n";
+			}
+		} else if (socket_buffer[0] == 'b') {
+			double start, stop;
+			unsigned int points;
+			if (sscanf(socket_buffer + 1, "%lf,%lf,%u", &start, &stop, &points) == 3) {
+				scope_parameters->bode_start = (start > 0.0)? start : BODE_DEFAULT_START;
+				scope_parameters->bode_stop = (stop > 0.0)? stop : BODE_DEFAULT_STOP;
+				scope_parameters->bode_points = (points < 2)? 2 : ((points > BODE_MAX_POINTS)? BODE_MAX_POINTS : points);
+				restart_acquisition = true;
+				if (operation_mode == MODE_BODE)
+					oXs_setup_gnuplot_bode_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+			} else {
+				std::cerr << "Communication error: malformed sweep settings...\n";
+			}
+		} else if (socket_buffer[0] == 'e') {
+			scope_parameters->measure = (socket_buffer[1] == '1');
+			restart_acquisition = true;
+		} else if (socket_buffer[0] == 'r') {
+			single_armed = true;
+			oXs_average_clear(&average);
+			oXs_envelope_clear(&envelope);
+			restart_acquisition = true;
+			pause_command = false;
 		} else if (socket_buffer[0] == 'p') {
 			pause_command = true;
 		} else if (socket_buffer[0] == 's') {
@@ -398,6 +792,9 @@ int main (int argc, char *argv[])
 			oXs_save_output_file(socket_buffer_msg, gnuplot_data);
 			pause_command = false;
 		} else if (socket_buffer[0] == 'm') {
+			if ((operation_mode == MODE_BODE) && (socket_buffer[1] != 'b'))
+				oXs_bode_stop(&bode);
+			restart_acquisition = true;
 			kill(-pid, 9);
 			pclose2(gnuplot_pipe, pid);
 			usleep(10000);
@@ -419,6 +816,18 @@ int main (int argc, char *argv[])
 				oXs_setup_gnuplot_voltmeter_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
 				operation_mode = MODE_VOLTMETER;
 				niter = -1;
+			} else if (socket_buffer[1] == 'f') {
+				oXs_setup_gnuplot_spectrum_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+				operation_mode = MODE_SPECTRUM;
+				niter = -1;
+			} else if (socket_buffer[1] == 'w') {
+				oXs_setup_gnuplot_waterfall_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+				operation_mode = MODE_WATERFALL;
+				niter = -1;
+			} else if (socket_buffer[1] == 'b') {
+				oXs_setup_gnuplot_bode_parameters(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+				operation_mode = MODE_BODE;
+				niter = -1;
 			}
 		} else if (socket_buffer[0] == 'n') {
 			pause_command = false;
@@ -427,11 +836,25 @@ int main (int argc, char *argv[])
 			usleep(1000000);
 			pause_command = false;
 		}
-		niter++;
+		if (refresh_display || (niter < 0))
+			niter++;
 	}
 
-	free(buf);
-	snd_pcm_close(device_handle);
+	double run_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - run_start).count();
+	unsigned long processed_frames = capture.ring.read_count.load();
+	oXs_capture_stop(&capture);
+	oXs_bode_stop(&bode);
+	std::cerr << "Capture statistics: " << capture.xruns.load() << " device overruns, " << capture.lost_frames.load() << " frames lost; " << capture.overruns.load() << " ring overruns, " << capture.dropped_frames.load() << " frames dropped, ring high-water mark " << capture.high_water.load() << " frames.\n";
+	std::cerr << "Engine throughput: " << processed_frames << " frames in " << run_time << " s (" << processed_frames / run_time << " frames/s).\n";
+	std::cerr << "Waveform capture rate: " << scan.completed << " waveforms in " << run_time << " s (" << scan.completed / run_time << " waveforms/s), " << scan.dropped << " triggers dropped with the pending queue full.\n";
+	oXs_trace_buffer_free(&trigger_data);
+	oXs_trace_buffer_free(&waveform_data);
+	remove(ROLL_FILE);
+	oXs_period_block_free(&block);
+	oXs_period_block_free(&levels);
+	if (decoder_output != NULL)
+		fclose(decoder_output);
+	delete source;
 	close(sockfd);
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "execute", "q", gnuplot_data);
 	usleep(100000);
@@ -442,105 +865,80 @@ int main (int argc, char *argv[])
 	exit(0);
 }
 
-bool oXs_trigger_crossing(std::deque<std::vector<double> > & data, std::vector<double> & xy_new, ScopeParameters* scope_parameters)
-{
-	bool crossed = false;
-
-	std::vector <double> xy_last = data.back();
-	double y_new = xy_new[scope_parameters->trig_chan - 1];
-	double y_last = xy_last[scope_parameters->trig_chan - 1];
-
-	if (scope_parameters->trig_rising_edge) {
-		if ((y_last < scope_parameters->trig_level) && (y_new >= scope_parameters->trig_level))
-			crossed = true;
-	} else {
-		if ((y_last > scope_parameters->trig_level) && (y_new <= scope_parameters->trig_level))
-			crossed = true;
-	}
-
-	return crossed;
-}
-
-void oXs_digital_acquisition(std::vector<double> & xy, std::deque< std::vector<double> > & sr, const int16_t* buf, int j)
+// Trigger times are set in seconds, and counted in samples.
+void oXs_setup_trigger_machine(TriggerMachine* trigger, const ScopeParameters* scope_parameters, unsigned int sample_rate)
 {
-	double m0 = 0.0, m1 = 0.0, s0 = 0.0, s1 = 0.0;
-	std::vector<double> x(2, 0.0);
-	x[0] = buf[j];
-	x[1] = buf[j+1];
-	sr.push_back(x);
-	if (sr.size() > DIG_SR_SIZE)
-		sr.pop_front();
-	for (int i = 0; i < sr.size(); i++) {
-		m0 += sr[i][0];
-		m1 += sr[i][1];
-		s0 += sr[i][0]*sr[i][0];
-		s1 += sr[i][1]*sr[i][1];
-	}
-	m0 /= (double) sr.size();
-	m1 /= (double) sr.size();
-	s0 /= (double) sr.size();
-	s1 /= (double) sr.size();
-	s0 -= m0*m0;
-	s1 -= m1*m1;
-
-	xy[0] = (sqrt(s0) < DIG_SIG_THR)? 0 : 1;
-	xy[1] = (sqrt(s1) < DIG_SIG_THR)? 0 : 1;
+	unsigned long time_min = lround(scope_parameters->trig_time_min * sample_rate);
+	unsigned long time_max = lround(scope_parameters->trig_time_max * sample_rate);
+	oXs_trigger_machine_setup(trigger, scope_parameters->trig_type, scope_parameters->trig_condition, scope_parameters->trig_rising_edge, scope_parameters->trig_level, scope_parameters->trig_level_high, scope_parameters->trig_hysteresis, time_min, time_max);
 
 	return;
 }
 
-bool oXs_trigger_digital(std::deque<std::vector<double> > & data, std::vector<double> & xy_new, ScopeParameters* scope_parameters)
+// Writes one row every `stride` samples of the trace.
+// The first sample is plotted at t = origin samples: for triggered traces,
+// the opposite of the pre-trigger, plus the sub-sample position of the
+// trigger, so that the trigger instant is drawn at t = 0.
+void oXs_fill_gnuplot_data(std::vector< std::vector<double> > & gnuplot_data, const TraceBuffer* trace, double dt, const double* k, unsigned int stride, double origin)
 {
-	bool crossed = false;
-
-	std::vector <double> xy_last = data.back();
-	double y_new = xy_new[scope_parameters->trig_chan - 1];
-	double y_last = xy_last[scope_parameters->trig_chan - 1];
-
-	if (scope_parameters->trig_rising_edge) {
-		if ((y_last == 0) && (y_new == 1))
-			crossed = true;
-	} else {
-		if ((y_last == 1) && (y_new == 0))
-			crossed = true;
+	unsigned int nr_columns = trace->nr_channels + 1;
+	unsigned int nr_rows = (trace->count + stride - 1) / stride;
+	if ((gnuplot_data.size() != nr_rows) || ((nr_rows > 0) && (gnuplot_data[0].size() != nr_columns)))
+		gnuplot_data.assign(nr_rows, std::vector<double>(nr_columns, 0.0));
+
+	double t = origin * dt;
+	for (unsigned int j = 0; j < nr_rows; j++) {
+		gnuplot_data[j][0] = t;
+		t += stride * dt;
+	}
+	for (unsigned int c = 0; c < trace->nr_channels; c++) {
+		const float* samples = trace->samples[c];
+		unsigned int i = oXs_trace_buffer_index(trace, 0);
+		for (unsigned int j = 0; j < nr_rows; j++) {
+			gnuplot_data[j][c + 1] = samples[i] * k[c];
+			i += stride;
+			if (i >= trace->capacity)
+				i -= trace->capacity;
+		}
 	}
 
-	return crossed;
+	return;
 }
 
-void oXs_voltmeter_acquisition(std::string & string_voltmeter_1, std::string & string_voltmeter_2, const std::deque< std::vector<double> > & collected_data, const ScopeParameters * scope_parameters)
+// Channels 1 and 2 are drawn against the left and right axes; further
+// channels share the left axis, rescaled so that one division corresponds
+// to their own vertical scale. Digital traces are stacked. Spectra are all
+// drawn against the left axis; Bode plots have the gain on the left axis and
+// the phase on the right one.
+std::string oXs_plot_command(osc_mode operation_mode, const ScopeParameters* scope_parameters)
 {
-	double V1 = 0.0, V2 = 0.0;
-
-	for (int i = 0; i < collected_data.size(); i++) {
-		V1 += fabs(collected_data[i][0]);
-		V2 += fabs(collected_data[i][1]);
-	}
-	V1 *= 2.0 * scope_parameters->y1_vps / (double) collected_data.size();
-	V2 *= 2.0 * scope_parameters->y2_vps / (double) collected_data.size();
-
-	string_voltmeter_1.clear();
-	string_voltmeter_2.clear();
-	char *str_V1 = (char *) malloc(sizeof(char) * 256);
-	char *str_V2 = (char *) malloc(sizeof(char) * 256);
-	if (scope_parameters->y1_vps != 1.0) {
-		sprintf(str_V1, "label 1 \"Ch1 = %.4f V\" at 0,0.5 center textcolor rgb '#d0d0d0' font \"mbfont:Courier,24\"", V1);
-	} else {
-		sprintf(str_V1, "label 1 \"Ch1 = %.f (a.u.)\" at 0,0.5 center textcolor rgb '#d0d0d0' font \"mbfont:Courier,24\"", V1);
+	static const char* colors[MAX_CHANNELS] = {"yellow", "cyan", "magenta", "#3080ff", "green", "orange", "red", "white"};
+	unsigned int nr_channels = scope_parameters->nr_channels;
+	std::string command;
+	char item[128];
+
+	if (operation_mode == MODE_XY)
+		return "u 2:3 w l lw 2 lc rgb 'magenta'";
+	if (operation_mode == MODE_BODE)
+		return "u 1:2 axis x1y1 w lp lw 2 pt 7 ps 0.5 lc rgb 'yellow', \"\" u 1:3 axis x1y2 w lp lw 2 pt 7 ps 0.5 lc rgb 'cyan'";
+
+	for (unsigned int c = 0; c < nr_channels; c++) {
+		if (operation_mode == MODE_SPECTRUM)
+			sprintf(item, "u 1:%u axis x1y1 w l lw 2 lc rgb '%s'", c + 2, colors[c]);
+		else if (operation_mode == MODE_DIGITAL)
+			sprintf(item, "u 1:($%u+%g) axis x1y1 w steps lw 3 lc rgb '%s'", c + 2, 1.2 * (nr_channels - 1 - c), colors[c]);
+		else if (c == 0)
+			sprintf(item, "u 1:2 axis x1y1 w l lw 3 lc rgb '%s'", colors[c]);
+		else if (c == 1)
+			sprintf(item, "u 1:3 axis x1y2 w l lw 3 lc rgb '%s'", colors[c]);
+		else
+			sprintf(item, "u 1:($%u*%g) axis x1y1 w l lw 3 lc rgb '%s'", c + 2, scope_parameters->ydiv[0] / scope_parameters->ydiv[c], colors[c]);
+		if (c > 0)
+			command += ", \"\" ";
+		command += item;
 	}
-	if (scope_parameters->y2_vps != 1.0) {
-		sprintf(str_V2, "label 2 \"Ch2 = %.4f V\" at 0,-0.5 center textcolor rgb '#d0d0d0' font \"mbfont:Courier,24\"", V2);
-	} else {
-		sprintf(str_V2, "label 2 \"Ch2 = %.f (a.u.)\" at 0,-0.5 center textcolor rgb '#d0d0d0' font \"mbfont:Courier,24\"", V2);
-	}
-
-	string_voltmeter_1 = str_V1;
-	string_voltmeter_2 = str_V2;
 
-	free(str_V1);
-	free(str_V2);
-
-	return;
+	return command;
 }
 
 void signalHandler(int signum)
@@ -571,23 +969,81 @@ void oXs_save_output_file(std::string file_name_and_path, std::vector< std::vect
 void oXs_default_scope_parameters(ScopeParameters* scope_parameters)
 {
 	scope_parameters->tdiv = 1e-4;
-	scope_parameters->y1div = 1e4;
-	scope_parameters->y2div = 1e4;
 	scope_parameters->trig_level = 0.0;
 	scope_parameters->trig_chan = 1;
 	scope_parameters->trig_rising_edge = true;
-	scope_parameters->y1_vps = 1.0;
-	scope_parameters->y2_vps = 1.0;
+	scope_parameters->trig_type = TRIG_EDGE;
+	scope_parameters->trig_condition = TRIG_LONGER;
+	scope_parameters->trig_hysteresis = 0.0;
+	scope_parameters->trig_level_high = 0.0;
+	scope_parameters->trig_time_min = 0.0;
+	scope_parameters->trig_time_max = 0.0;
+	scope_parameters->trig_sweep = SWEEP_AUTO;
+	scope_parameters->trig_holdoff = 0.0;
+	scope_parameters->trig_auto_timeout = DEFAULT_AUTO_TIMEOUT;
+	scope_parameters->trig_position = 0.5;
+	scope_parameters->trig_delay = 0.0;
 	scope_parameters->navg = 1;
+	scope_parameters->avg_mode = AVG_RUNNING;
+	scope_parameters->acq_mode = ACQ_SAMPLE;
+	scope_parameters->dig_window = DIG_SR_SIZE;
+	scope_parameters->dig_threshold = DIG_SIG_THR;
+	scope_parameters->dec_type = DEC_NONE;
+	scope_parameters->dec_channel = 0;
+	scope_parameters->dec_baud = DECODER_DEFAULT_BAUD;
+	scope_parameters->vm_interval = VOLTMETER_DEFAULT_INTERVAL;
+	scope_parameters->measure = false;
+	scope_parameters->spec_window = WIN_HANN;
+	scope_parameters->spec_scale = SCALE_DB;
+	scope_parameters->spec_averaging = SPEC_AVG_NONE;
+	scope_parameters->bode_start = BODE_DEFAULT_START;
+	scope_parameters->bode_stop = BODE_DEFAULT_STOP;
+	scope_parameters->bode_points = BODE_DEFAULT_POINTS;
+	scope_parameters->sample_rate = DEFAULT_SAMPLING_RATE;
+	scope_parameters->nr_channels = 2;
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++) {
+		scope_parameters->ydiv[c] = 1e4;
+		scope_parameters->y_vps[c] = 1.0;
+	}
+
+	return;
+}
+
+// Number of samples preceding the trigger sample in a trace; the trigger
+// delay moves the trace past the trigger, possibly beyond the trace itself,
+// in which case the pre-trigger is negative.
+long oXs_pre_trigger(const ScopeParameters* scope_parameters, unsigned int trace_size, unsigned int sample_rate)
+{
+	return lround(scope_parameters->trig_position * trace_size) - lround(scope_parameters->trig_delay * sample_rate);
+}
+
+// Time of the left edge of the screen in triggered modes, t = 0 being the
+// trigger instant.
+double oXs_trace_begin_time(const ScopeParameters* scope_parameters)
+{
+	return scope_parameters->trig_delay - scope_parameters->trig_position * scope_parameters->tdiv * HORIZ_DIVS;
+}
+
+// A small mark at the top of the screen shows the trigger instant, unless
+// the trigger delay has moved it off screen; roll mode has no trigger.
+void oXs_set_gnuplot_trigger_marker(FILE* gnuplot_pipe, char* gnuplot_fifo, const ScopeParameters* scope_parameters)
+{
+	std::vector< std::vector<double> > dummy;
+	if ((scope_parameters->tdiv >= ROLL_MIN_TDIV) || (oXs_trace_begin_time(scope_parameters) > 0.0)) {
+		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", "arrow 1", dummy);
+	} else {
+		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "arrow 1 from first 0, graph 1 to first 0, graph 0.96 lw 2 lc rgb 'orange' front", dummy);
+	}
 
 	return;
 }
 
 void oXs_setup_gnuplot_analog_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
 {
-	double tlim = scope_parameters->tdiv * HORIZ_DIVS / 2.0;
-	double y1lim = scope_parameters->y1div * VERTC_DIVS / 2.0;
-	double y2lim = scope_parameters->y2div * VERTC_DIVS / 2.0;
+	double tbegin = oXs_trace_begin_time(scope_parameters);
+	double tend = tbegin + scope_parameters->tdiv * HORIZ_DIVS;
+	double y1lim = scope_parameters->ydiv[0] * VERTC_DIVS / 2.0;
+	double y2lim = scope_parameters->ydiv[1] * VERTC_DIVS / 2.0;
 
 	char* xrange = (char *) malloc(sizeof(char) * 128);
 	char* y1range = (char *) malloc(sizeof(char) * 128);
@@ -596,12 +1052,12 @@ void oXs_setup_gnuplot_analog_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo,
 	char* y1tics = (char *) malloc(sizeof(char) * 128);
 	char* y2tics = (char *) malloc(sizeof(char) * 128);
 
-	sprintf(xrange, "xrange [%f:%f]", -tlim, tlim);
+	sprintf(xrange, "xrange [%f:%f]", tbegin, tend);
 	sprintf(y1range, "yrange [%f:%f]", -y1lim, y1lim);
 	sprintf(y2range, "y2range [%f:%f]", -y2lim, y2lim);
-	sprintf(xtics, "xtics %f, %f, %f format \"\"", -tlim, scope_parameters->tdiv, tlim);
-	sprintf(y1tics, "ytics %f, %f, %f", -y1lim, scope_parameters->y1div, y1lim);
-	sprintf(y2tics, "y2tics %f, %f, %f", -y2lim, scope_parameters->y2div, y2lim);
+	sprintf(xtics, "xtics %f, %f, %f format \"\"", tbegin, scope_parameters->tdiv, tend);
+	sprintf(y1tics, "ytics %f, %f, %f", -y1lim, scope_parameters->ydiv[0], y1lim);
+	sprintf(y2tics, "y2tics %f, %f, %f", -y2lim, scope_parameters->ydiv[1], y2lim);
 
 	std::vector< std::vector<double> > dummy;
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xrange, dummy);
@@ -610,12 +1066,13 @@ void oXs_setup_gnuplot_analog_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo,
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xtics, dummy);
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1tics, dummy);
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2tics, dummy);
-	if (scope_parameters->y1_vps != 1.0)
+	oXs_set_gnuplot_trigger_marker(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+	if (scope_parameters->y_vps[0] != 1.0)
 		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "ylabel \"Channel 1 (V)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
 	else
 		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "ylabel \"Channel 1 (a.u.)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
 
-	if (scope_parameters->y2_vps != 1.0)
+	if (scope_parameters->y_vps[1] != 1.0)
 		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2label \"Channel 2 (V)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
 	else
 		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2label \"Channel 2 (a.u.)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
@@ -632,8 +1089,8 @@ void oXs_setup_gnuplot_analog_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo,
 
 void oXs_setup_gnuplot_xy_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
 {
-	double y1lim = scope_parameters->y1div * XY_DIVS / 2.0;
-	double y2lim = scope_parameters->y2div * XY_DIVS / 2.0;
+	double y1lim = scope_parameters->ydiv[0] * XY_DIVS / 2.0;
+	double y2lim = scope_parameters->ydiv[1] * XY_DIVS / 2.0;
 
 	char* xrange = (char *) malloc(sizeof(char) * 128);
 	char* y1range = (char *) malloc(sizeof(char) * 128);
@@ -643,8 +1100,8 @@ void oXs_setup_gnuplot_xy_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, Sco
 
 	sprintf(xrange, "xrange [%f:%f]", -y1lim, y1lim);
 	sprintf(y1range, "yrange [%f:%f]", -y2lim, y2lim);
-	sprintf(xtics, "xtics %f, %f, %f format \"%%.3f\"", -y1lim, scope_parameters->y1div, y1lim);
-	sprintf(y1tics, "ytics %f, %f, %f format \"%%.3f\"", -y2lim, scope_parameters->y2div, y2lim);
+	sprintf(xtics, "xtics %f, %f, %f format \"%%.3f\"", -y1lim, scope_parameters->ydiv[0], y1lim);
+	sprintf(y1tics, "ytics %f, %f, %f format \"%%.3f\"", -y2lim, scope_parameters->ydiv[1], y2lim);
 	sprintf(y2tics, "y2tics format \"\"");
 
 	std::vector< std::vector<double> > dummy;
@@ -654,11 +1111,11 @@ void oXs_setup_gnuplot_xy_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, Sco
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xtics, dummy);
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1tics, dummy);
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2tics, dummy);
-	if (scope_parameters->y1_vps != 1.0)
+	if (scope_parameters->y_vps[0] != 1.0)
 		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "xlabel \"Channel 1 (V)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
 	else
 		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "xlabel \"Channel 1 (a.u.)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
-	if (scope_parameters->y2_vps != 1.0)
+	if (scope_parameters->y_vps[1] != 1.0)
 		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y1label \"Channel 2 (V)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
 	else
 		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y1label \"Channel 2 (a.u.)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
@@ -675,7 +1132,8 @@ void oXs_setup_gnuplot_xy_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, Sco
 
 void oXs_setup_gnuplot_digital_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
 {
-	double tlim = scope_parameters->tdiv * HORIZ_DIVS / 2.0;
+	double tbegin = oXs_trace_begin_time(scope_parameters);
+	double tend = tbegin + scope_parameters->tdiv * HORIZ_DIVS;
 
 	char* xrange = (char *) malloc(sizeof(char) * 128);
 	char* y1range = (char *) malloc(sizeof(char) * 128);
@@ -684,12 +1142,26 @@ void oXs_setup_gnuplot_digital_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo
 	char* y1tics = (char *) malloc(sizeof(char) * 128);
 	char* y2tics = (char *) malloc(sizeof(char) * 128);
 
-	sprintf(xrange, "xrange [%f:%f]", -tlim, tlim);
-	sprintf(y1range, "yrange [-0.2:2.4]");
-	sprintf(y2range, "y2range [-0.2:2.4]");
-	sprintf(xtics, "xtics %f, %f, %f format \"\"", -tlim, scope_parameters->tdiv, tlim);
-	sprintf(y1tics, "ytics (\"0\" 1.2, \"1\" 2.2)");
-	sprintf(y2tics, "y2tics 0, 1, 1");
+	unsigned int nr_channels = scope_parameters->nr_channels;
+	std::string ytics_levels = "ytics (";
+	std::string ytics_names = "y2tics (";
+	for (unsigned int c = 0; c < nr_channels; c++) {
+		char item[64];
+		double offset = 1.2 * (nr_channels - 1 - c);
+		sprintf(item, "%s\"0\" %g, \"1\" %g", (c > 0)? ", " : "", offset, offset + 1.0);
+		ytics_levels += item;
+		sprintf(item, "%s\"Ch%u\" %g", (c > 0)? ", " : "", c + 1, offset + 0.5);
+		ytics_names += item;
+	}
+	ytics_levels += ")";
+	ytics_names += ")";
+
+	sprintf(xrange, "xrange [%f:%f]", tbegin, tend);
+	sprintf(y1range, "yrange [-0.2:%g]", 1.2 * nr_channels);
+	sprintf(y2range, "y2range [-0.2:%g]", 1.2 * nr_channels);
+	sprintf(xtics, "xtics %f, %f, %f format \"\"", tbegin, scope_parameters->tdiv, tend);
+	sprintf(y1tics, "%s", ytics_levels.c_str());
+	sprintf(y2tics, "%s", ytics_names.c_str());
 
 	std::vector< std::vector<double> > dummy;
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xrange, dummy);
@@ -698,8 +1170,9 @@ void oXs_setup_gnuplot_digital_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xtics, dummy);
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1tics, dummy);
 	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y2tics, dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "ylabel \"Channel 1\" textcolor rgb '#d0d0d0' offset 0,7", dummy);
-	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2label \"Channel 2\" textcolor rgb '#d0d0d0' offset 0,-6", dummy);
+	oXs_set_gnuplot_trigger_marker(gnuplot_pipe, gnuplot_fifo, scope_parameters);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "ylabel \"Logic level\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2label \"\"", dummy);
 
 	free(xrange);
 	free(y1range);
@@ -749,6 +1222,145 @@ void oXs_setup_gnuplot_voltmeter_parameters(FILE* gnuplot_pipe, char* gnuplot_fi
 	return;
 }
 
+// Frequencies run from DC to the Nyquist frequency. In dB, the top of the
+// screen is 0 dBFS, or +20 dBV for a calibrated channel 1, with
+// SPECTRUM_DB_PER_DIV per division; in linear scale, amplitudes span the
+// vertical scale of channel 1 from the bottom of the screen.
+void oXs_setup_gnuplot_spectrum_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
+{
+	double fmax = scope_parameters->sample_rate / 2.0;
+	bool calibrated = (scope_parameters->y_vps[0] != 1.0);
+	double ytop, ystep;
+	if (scope_parameters->spec_scale == SCALE_DB) {
+		ytop = (calibrated)? 20.0 : 0.0;
+		ystep = SPECTRUM_DB_PER_DIV;
+	} else {
+		ytop = scope_parameters->ydiv[0] * VERTC_DIVS;
+		ystep = scope_parameters->ydiv[0];
+	}
+	double ybottom = ytop - ystep * VERTC_DIVS;
+
+	char* xrange = (char *) malloc(sizeof(char) * 128);
+	char* y1range = (char *) malloc(sizeof(char) * 128);
+	char* xtics = (char *) malloc(sizeof(char) * 128);
+	char* y1tics = (char *) malloc(sizeof(char) * 128);
+
+	sprintf(xrange, "xrange [0:%f]", fmax);
+	sprintf(y1range, "yrange [%f:%f]", ybottom, ytop);
+	sprintf(xtics, "xtics 0, %f, %f format \"%%.3s%%c\"", fmax / HORIZ_DIVS, fmax);
+	sprintf(y1tics, "ytics %f, %f, %f", ybottom, ystep, ytop);
+
+	std::vector< std::vector<double> > dummy;
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xrange, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1range, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xtics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1tics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", "y2tics", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", "arrow 1", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "xlabel \"Frequency (Hz)\" textcolor rgb '#d0d0d0'", dummy);
+	if (scope_parameters->spec_scale == SCALE_DB)
+		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", (calibrated)? "ylabel \"Magnitude (dBV)\" textcolor rgb '#d0d0d0' offset 0,0" : "ylabel \"Magnitude (dBFS)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
+	else
+		GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", (calibrated)? "ylabel \"Amplitude (V)\" textcolor rgb '#d0d0d0' offset 0,0" : "ylabel \"Amplitude (a.u.)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2label \"\"", dummy);
+
+	free(xrange);
+	free(y1range);
+	free(xtics);
+	free(y1tics);
+
+	return;
+}
+
+// Time runs from the oldest column of the spectrogram to the latest one, at
+// t = 0; frequencies from DC to the Nyquist frequency. Colours span
+// WATERFALL_DB_RANGE below 0 dBFS, or below +20 dBV for a calibrated
+// channel.
+void oXs_setup_gnuplot_waterfall_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
+{
+	unsigned int trace_size = ceil(scope_parameters->tdiv * HORIZ_DIVS * scope_parameters->sample_rate);
+	double span = oXs_waterfall_span(oXs_waterfall_size(trace_size), scope_parameters->sample_rate);
+	double fmax = scope_parameters->sample_rate / 2.0;
+	bool calibrated = (scope_parameters->y_vps[scope_parameters->trig_chan - 1] != 1.0);
+	double top = (calibrated)? 20.0 : 0.0;
+
+	char* xrange = (char *) malloc(sizeof(char) * 128);
+	char* y1range = (char *) malloc(sizeof(char) * 128);
+	char* cbrange = (char *) malloc(sizeof(char) * 128);
+	char* y1tics = (char *) malloc(sizeof(char) * 128);
+	char* cblabel = (char *) malloc(sizeof(char) * 128);
+
+	sprintf(xrange, "xrange [%f:0]", -span);
+	sprintf(y1range, "yrange [0:%f]", fmax);
+	sprintf(cbrange, "cbrange [%f:%f]", top - WATERFALL_DB_RANGE, top);
+	sprintf(y1tics, "ytics 0, %f, %f format \"%%.3s%%c\"", fmax / VERTC_DIVS, fmax);
+	sprintf(cblabel, "cblabel \"Channel %u (%s)\" textcolor rgb '#d0d0d0'", scope_parameters->trig_chan, (calibrated)? "dBV" : "dBFS");
+
+	std::vector< std::vector<double> > dummy;
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xrange, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1range, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", cbrange, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "xtics format \"%g\"", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1tics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", "y2tics", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", "arrow 1", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "palette rgbformulae 34,35,36", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "cbtics textcolor rgb '#d0d0d0'", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", cblabel, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "ylabel \"Frequency (Hz)\" textcolor rgb '#d0d0d0' offset 0,0", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2label \"\"", dummy);
+
+	free(xrange);
+	free(y1range);
+	free(cbrange);
+	free(y1tics);
+	free(cblabel);
+
+	return;
+}
+
+// Frequencies on a logarithmic axis over the sweep (its end clipped below
+// the Nyquist frequency, as in oXs_bode_reset); the gain, in dB, on the
+// left axis at 10 dB per division from +20 dB down, and the phase on the
+// right one, from -180 to +180 degrees.
+void oXs_setup_gnuplot_bode_parameters(FILE* gnuplot_pipe, char* gnuplot_fifo, ScopeParameters* scope_parameters)
+{
+	double fstop = std::min(scope_parameters->bode_stop, 0.45 * scope_parameters->sample_rate);
+	double fstart = std::max(scope_parameters->bode_start, 1.0);
+	if (fstart >= fstop)
+		fstart = fstop / 10.0;
+	double ytop = 20.0;
+	double ybottom = ytop - 10.0 * VERTC_DIVS;
+
+	char* xrange = (char *) malloc(sizeof(char) * 128);
+	char* y1range = (char *) malloc(sizeof(char) * 128);
+	char* y1tics = (char *) malloc(sizeof(char) * 128);
+
+	sprintf(xrange, "xrange [%f:%f]", fstart, fstop);
+	sprintf(y1range, "yrange [%f:%f]", ybottom, ytop);
+	sprintf(y1tics, "ytics %f, %f, %f", ybottom, 10.0, ytop);
+
+	std::vector< std::vector<double> > dummy;
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "logscale x", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", xrange, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1range, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2range [-180:180]", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "xtics format \"%.0s%c\"", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "mxtics 10", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", y1tics, dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2tics -180, 45, 180", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "unset", "arrow 1", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "xlabel \"Frequency (Hz)\" textcolor rgb '#d0d0d0'", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "ylabel \"Gain ch2/ch1 (dB)\" textcolor rgb 'yellow' offset 0,0", dummy);
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "set", "y2label \"Phase (deg)\" textcolor rgb 'cyan' offset 0,0", dummy);
+
+	free(xrange);
+	free(y1range);
+	free(y1tics);
+
+	return;
+}
+
 void oXs_setup_oscilloscope_screen(FILE* gnuplot_pipe, char* gnuplot_fifo)
 {
 	std::vector< std::vector<double> >	dummy;
@@ -766,42 +1378,97 @@ void oXs_setup_oscilloscope_screen(FILE* gnuplot_pipe, char* gnuplot_fifo)
 	return;
 }
 
-int oXs_hardware_setup_capture(snd_pcm_t* device_handle, snd_pcm_hw_params_t* device_parameters, unsigned int* sample_rate)
+void oXs_default_engine_options(EngineOptions* engine_options)
 {
-	int err;
-	if (snd_pcm_hw_params_malloc(&device_parameters) < 0) {
-		std::cerr <<  "Could not allocate hardware parameter structure\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_any(device_handle, device_parameters)) < 0) {
-		std::cerr <<  "cannot initialize hardware parameter structure\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_set_access(device_handle, device_parameters, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
-		std::cerr <<  "cannot set access type\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_set_format(device_handle, device_parameters, SND_PCM_FORMAT_S16_LE)) < 0) {
-		std::cerr <<  "cannot set sample format\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_set_rate_near(device_handle, device_parameters, sample_rate, 0)) < 0) {
-		std::cerr <<  "cannot set sample rate\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params_set_channels(device_handle, device_parameters, 2)) < 0) {
-		std::cerr <<  "cannot set channel count\n";
-		exit(1);
-	}
-	if ((err = snd_pcm_hw_params(device_handle, device_parameters)) < 0) {
-		std::cerr <<  "cannot set parameters\n";
-		exit(1);
+	engine_options->device_name = "default";
+	engine_options->access = SND_PCM_ACCESS_RW_INTERLEAVED;
+	engine_options->format = SND_PCM_FORMAT_S16_LE;
+	engine_options->nr_channels = 2;
+	engine_options->source_spec = "alsa";
+	engine_options->pace_realtime = true;
+	engine_options->sample_rate = DEFAULT_SAMPLING_RATE;
+	engine_options->period_size = DEFAULT_PERIOD_SIZE;
+	engine_options->buffer_size = 0;
+
+	return;
+}
+
+void oXs_parse_command_line(int argc, char* argv[], EngineOptions* engine_options)
+{
+	int opt;
+	while ((opt = getopt(argc, argv, "S:P:D:A:f:c:r:p:b:o:Bh")) != -1) {
+		switch (opt) {
+			case 'S':
+				engine_options->source_spec = optarg;
+				break;
+			case 'P':
+				if (!strcmp(optarg, "realtime")) {
+					engine_options->pace_realtime = true;
+				} else if (!strcmp(optarg, "fast")) {
+					engine_options->pace_realtime = false;
+				} else {
+					std::cerr << "Unknown pace '" << optarg << "' (use 'realtime' or 'fast').\n";
+					exit(1);
+				}
+				break;
+			case 'D':
+				engine_options->device_name = optarg;
+				break;
+			case 'A':
+				if (!strcmp(optarg, "mmap")) {
+					engine_options->access = SND_PCM_ACCESS_MMAP_INTERLEAVED;
+				} else if (!strcmp(optarg, "rw")) {
+					engine_options->access = SND_PCM_ACCESS_RW_INTERLEAVED;
+				} else {
+					std::cerr << "Unknown access type '" << optarg << "' (use 'rw' or 'mmap').\n";
+					exit(1);
+				}
+				break;
+			case 'f':
+				if (!oXs_parse_format(optarg, &(engine_options->format))) {
+					std::cerr << "Unknown sample format '" << optarg << "' (use 's16', 's24', 's32', 'float' or 'auto').\n";
+					exit(1);
+				}
+				break;
+			case 'c':
+				engine_options->nr_channels = atoi(optarg);
+				break;
+			case 'r':
+				engine_options->sample_rate = atoi(optarg);
+				break;
+			case 'p':
+				engine_options->period_size = atoi(optarg);
+				break;
+			case 'b':
+				engine_options->buffer_size = atoi(optarg);
+				break;
+			case 'o':
+				engine_options->decoder_output = optarg;
+				break;
+			case 'B':
+				exit(oXs_trigger_benchmark());
+			case 'h':
+			default:
+				std::cerr << "Usage: " << argv[0] << " [-S source] [-P realtime|fast] [-D pcm_device] [-A rw|mmap] [-f format] [-c channels] [-r rate] [-p period] [-b buffer] [-o file] [-B]\n";
+				std::cerr << "  -S source        'alsa' (default), 'file:<wav or raw file>', 'synth[:f1[,f2]]'\n";
+				std::cerr << "  -P realtime|fast pace of file and synthesizer sources (default: realtime)\n";
+				std::cerr << "  -D pcm_device    ALSA capture device (default: 'default'; e.g. 'hw:1', 'null')\n";
+				std::cerr << "  -A rw|mmap       access type; mmap falls back to rw if refused (default: rw)\n";
+				std::cerr << "  -f format        s16, s24 (S24_3LE), s32, float, or auto for the widest the device offers (default: s16);\n";
+				std::cerr << "                   also the format of raw files and of the synthesizer\n";
+				std::cerr << "  -c channels      number of channels to capture, 1 to " << MAX_CHANNELS << " (default: 2); also used for raw files\n";
+				std::cerr << "  -r rate          requested sampling rate in Hz (default: " << DEFAULT_SAMPLING_RATE << ")\n";
+				std::cerr << "  -p period        requested period size in frames (default: " << DEFAULT_PERIOD_SIZE << ")\n";
+				std::cerr << "  -b buffer        requested ALSA buffer size in frames (default: chosen by the driver)\n";
+				std::cerr << "  -o file          append the bytes decoded in digital mode to file\n";
+				std::cerr << "  -B               benchmark the trigger search kernels and exit\n";
+				exit((opt == 'h')? 0 : 1);
+		}
 	}
-	snd_pcm_nonblock(device_handle, 0);
-	if ((err = snd_pcm_prepare(device_handle)) < 0) {
-		std::cerr <<  "cannot prepare audio interface for use\n";
+	if ((engine_options->sample_rate < 1000) || (engine_options->period_size < 16) || (engine_options->nr_channels < 1) || (engine_options->nr_channels > MAX_CHANNELS)) {
+		std::cerr << "Invalid sampling rate, period size or number of channels.\n";
 		exit(1);
 	}
 
-	return 0;
+	return;
 }
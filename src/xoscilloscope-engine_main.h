@@ -38,50 +38,126 @@
 #include <sys/stat.h>
 #include <sys/socket.h>
 #include <sys/un.h>
+#include <chrono>
 #include <alsa/asoundlib.h>
 
-#define SOCKET_BUFFER_SIZE 128
-#define BUF_SIZE 441
-#define CHN_SIZE 2
-#define SAMPLING_RATE 44100
+#include "xoscilloscope-engine_buffer.h"
+#include "xoscilloscope-engine_format.h"
+#include "xoscilloscope-engine_source.h"
+#include "xoscilloscope-engine_capture.h"
+#include "xoscilloscope-engine_trigger.h"
+#include "xoscilloscope-engine_roll.h"
+#include "xoscilloscope-engine_average.h"
+#include "xoscilloscope-engine_envelope.h"
+#include "xoscilloscope-engine_digital.h"
+#include "xoscilloscope-engine_decoder.h"
+#include "xoscilloscope-engine_voltmeter.h"
+#include "xoscilloscope-engine_measure.h"
+#include "xoscilloscope-engine_spectrum.h"
+#include "xoscilloscope-engine_waterfall.h"
+#include "xoscilloscope-engine_bode.h"
+
+#define SOCKET_BUFFER_SIZE 256
+#define DEFAULT_PERIOD_SIZE 441
+#define DEFAULT_SAMPLING_RATE 44100
 #define REFRESH_GP 5000
 #define HORIZ_DIVS 14
 #define VERTC_DIVS 8
 #define XY_DIVS 6
-#define DIG_SR_SIZE 24
-#define DIG_SIG_THR 8192
+#define XY_MAX_POINTS 20000
+#define DEFAULT_AUTO_TIMEOUT 0.1
+#define TRIGGER_POLL_INTERVAL 0.05
+#define MAX_TRIGGER_DELAY 10.0
 
 struct ScopeParameters {
 	bool trig_rising_edge;
 	unsigned int trig_chan;
 	double tdiv;
-	double y1div;
-	double y2div;
 	double trig_level;
-	double y1_vps;
-	double y2_vps;
+	trigger_type trig_type;
+	trigger_condition trig_condition;
+	double trig_hysteresis;
+	double trig_level_high;
+	double trig_time_min;
+	double trig_time_max;
+	sweep_mode trig_sweep;
+	double trig_holdoff;
+	double trig_auto_timeout;
+	double trig_position;
+	double trig_delay;
 	unsigned int navg;
+	average_mode avg_mode;
+	acquisition_mode acq_mode;
+	unsigned int dig_window;
+	double dig_threshold;
+	decoder_type dec_type;
+	unsigned int dec_channel;
+	double dec_baud;
+	double vm_interval;
+	bool measure;
+	spectrum_window spec_window;
+	spectrum_scale spec_scale;
+	spectrum_averaging spec_averaging;
+	double bode_start;
+	double bode_stop;
+	unsigned int bode_points;
+	unsigned int sample_rate;
+	unsigned int nr_channels;
+	double ydiv[MAX_CHANNELS];
+	double y_vps[MAX_CHANNELS];
+};
+
+struct EngineOptions {
+	std::string		source_spec;
+	bool			pace_realtime;
+	std::string		device_name;
+	snd_pcm_access_t	access;
+	snd_pcm_format_t	format;
+	unsigned int		nr_channels;
+	unsigned int		sample_rate;
+	unsigned int		period_size;
+	unsigned int		buffer_size;
+	std::string		decoder_output;
 };
 
 enum osc_mode : unsigned int {
 	MODE_ANALOG,
 	MODE_XY,
 	MODE_DIGITAL,
-	MODE_VOLTMETER
+	MODE_VOLTMETER,
+	MODE_SPECTRUM,
+	MODE_WATERFALL,
+	MODE_BODE
+};
+
+// Reported to the console: waveforms are being triggered (or, in auto
+// sweeps, displayed anyway), a normal sweep is waiting for a trigger, a
+// single sweep is armed, or its shot has been taken.
+enum trigger_status : unsigned int {
+	STATUS_TRIGGERED,
+	STATUS_WAITING,
+	STATUS_ARMED,
+	STATUS_STOPPED
 };
 
 bool requested_termination;
 void signalHandler(int);
 
-int oXs_hardware_setup_capture(snd_pcm_t*, snd_pcm_hw_params_t*, unsigned int*);
+void oXs_default_engine_options(EngineOptions*);
+void oXs_parse_command_line(int, char**, EngineOptions*);
 void oXs_default_scope_parameters(ScopeParameters*);
 void oXs_setup_oscilloscope_screen(FILE*, char*);
+long oXs_pre_trigger(const ScopeParameters*, unsigned int, unsigned int);
+double oXs_trace_begin_time(const ScopeParameters*);
+void oXs_set_gnuplot_trigger_marker(FILE*, char*, const ScopeParameters*);
 void oXs_setup_gnuplot_analog_parameters(FILE*, char*, ScopeParameters*);
 void oXs_setup_gnuplot_xy_parameters(FILE*, char*, ScopeParameters*);
 void oXs_setup_gnuplot_digital_parameters(FILE*, char*, ScopeParameters*);
 void oXs_setup_gnuplot_voltmeter_parameters(FILE*, char*, ScopeParameters*);
-bool oXs_trigger_crossing(std::deque<std::vector<double> > &, std::vector<double> &, ScopeParameters*);
-void oXs_digital_acquisition(std::vector<double> &, std::deque<std::vector<double> > &, const short*, int);
-void oXs_voltmeter_acquisition(std::string &, std::string &, const std::deque< std::vector<double> > &, const ScopeParameters *);
-bool oXs_trigger_digital(std::deque<std::vector<double> > &, std::vector<double> &, ScopeParameters*);
+void oXs_setup_gnuplot_spectrum_parameters(FILE*, char*, ScopeParameters*);
+void oXs_setup_gnuplot_waterfall_parameters(FILE*, char*, ScopeParameters*);
+void oXs_setup_gnuplot_bode_parameters(FILE*, char*, ScopeParameters*);
+void oXs_setup_trigger_machine(TriggerMachine*, const ScopeParameters*, unsigned int);
+void oXs_fill_gnuplot_data(std::vector< std::vector<double> > &, const TraceBuffer*, double, const double*, unsigned int, double);
+std::string oXs_plot_command(osc_mode, const ScopeParameters*);
 void oXs_save_output_file(std::string, std::vector< std::vector<double> > &);
@@ -0,0 +1,284 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <cmath>
+#include <cstdio>
+#include <algorithm>
+
+#include "xoscilloscope-engine_measure.h"
+
+// Rising edges of a channel around a reference instant: the latest one
+// before it and the first one at or after it (NaN if none).
+struct EdgesAround {
+	double	reference;
+	double	before;
+	double	after;
+};
+
+void oXs_measure_reset(WaveformMeasure* measure, unsigned int nr_channels, double dt)
+{
+	measure->extrema = oXs_select_extrema_kernel();
+	measure->nr_channels = nr_channels;
+	measure->dt = dt;
+	measure->histogram.assign(MEASURE_HISTOGRAM_BINS, 0);
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++) {
+		for (unsigned int q = 0; q < MEAS_QUANTITIES; q++) {
+			measure->value[c][q] = NAN;
+			measure->sum[c][q] = 0.0;
+			measure->taken[c][q] = 0;
+		}
+	}
+	measure->count = 0;
+
+	return;
+}
+
+static inline double oXs_measure_crossing(float previous, float x, float level, unsigned int i)
+{
+	return (double) i - 1.0 + (level - previous) / (x - previous);
+}
+
+// Second pass over one channel: times are in samples, at the linearly
+// interpolated crossings. An edge is a move from below the 10% level to
+// above the 90% level (or back); its rise (fall) time runs from the latest
+// crossing of the first to the crossing of the second, and its instant is
+// its latest 50% crossing. The period is the mean spacing of the rising
+// edges, and the duty cycle the time spent high within the whole cycles
+// between the first and the last of them. Gaps (NaN samples) break edges.
+static void oXs_measure_channel(WaveformMeasure* measure, const float* x, unsigned int n, float lo, float hi, double* result, EdgesAround* around)
+{
+	for (unsigned int q = 0; q < MEAS_QUANTITIES; q++)
+		result[q] = NAN;
+	if (!(hi > lo) || (n < 2))
+		return;
+	float a = hi - lo;
+	float l10 = lo + 0.1 * a, l50 = lo + 0.5 * a, l90 = lo + 0.9 * a;
+	float scale = (MEASURE_HISTOGRAM_BINS - 1) / a;
+	unsigned int* histogram = measure->histogram.data();
+	std::fill(histogram, histogram + MEASURE_HISTOGRAM_BINS, 0);
+
+	int extreme = -1;
+	double t10 = 0.0, t90 = 0.0, t50 = 0.0;
+	double first_rise = NAN, last_rise = NAN, last_fall = NAN;
+	unsigned int nr_rises = 0, nr_falls = 0;
+	double rise_total = 0.0, fall_total = 0.0, high_total = 0.0;
+	float previous = NAN;
+	for (unsigned int i = 0; i < n; i++) {
+		float v = x[i];
+		if (v != v) {
+			extreme = -1;
+			previous = v;
+			continue;
+		}
+		histogram[(unsigned int) ((v - lo) * scale)]++;
+		if (previous != previous) {
+			extreme = (v < l10)? 0 : ((v > l90)? 2 : -1);
+		} else if (v > previous) {
+			if ((previous < l10) && (v >= l10))
+				t10 = oXs_measure_crossing(previous, v, l10, i);
+			if ((previous < l50) && (v >= l50))
+				t50 = oXs_measure_crossing(previous, v, l50, i);
+			if ((previous < l90) && (v >= l90)) {
+				if (extreme == 0) {
+					rise_total += oXs_measure_crossing(previous, v, l90, i) - t10;
+					if ((nr_rises > 0) && (last_fall > last_rise))
+						high_total += last_fall - last_rise;
+					if (nr_rises == 0)
+						first_rise = t50;
+					last_rise = t50;
+					nr_rises++;
+					if (t50 < around->reference)
+						around->before = t50;
+					else if (around->after != around->after)
+						around->after = t50;
+				}
+				extreme = 2;
+			}
+		} else if (v < previous) {
+			if ((previous > l90) && (v <= l90))
+				t90 = oXs_measure_crossing(previous, v, l90, i);
+			if ((previous > l50) && (v <= l50))
+				t50 = oXs_measure_crossing(previous, v, l50, i);
+			if ((previous > l10) && (v <= l10)) {
+				if (extreme == 2) {
+					fall_total += oXs_measure_crossing(previous, v, l10, i) - t90;
+					last_fall = t50;
+					nr_falls++;
+				}
+				extreme = 0;
+			}
+		}
+		previous = v;
+	}
+
+	double dt = measure->dt;
+	if (nr_rises > 1) {
+		result[MEAS_FREQUENCY] = (nr_rises - 1) / ((last_rise - first_rise) * dt);
+		result[MEAS_PERIOD] = (last_rise - first_rise) * dt / (nr_rises - 1);
+		result[MEAS_DUTY] = 100.0 * high_total / (last_rise - first_rise);
+	}
+	if (nr_rises > 0)
+		result[MEAS_RISE] = rise_total * dt / nr_rises;
+	if (nr_falls > 0)
+		result[MEAS_FALL] = fall_total * dt / nr_falls;
+	unsigned int half = MEASURE_HISTOGRAM_BINS / 2;
+	unsigned int base = std::max_element(histogram, histogram + half) - histogram;
+	unsigned int top = MEASURE_HISTOGRAM_BINS - 1;
+	for (unsigned int k = MEASURE_HISTOGRAM_BINS - 1; k-- > half; ) {
+		if (histogram[k] > histogram[top])
+			top = k;
+	}
+	if (histogram[top] > 0) {
+		// The top level is the centre of its bin.
+		double top_level = lo + (top + 0.5) / scale, base_level = lo + (base + 0.5) / scale;
+		result[MEAS_OVERSHOOT] = (hi > top_level)? 100.0 * (hi - top_level) / (top_level - base_level) : 0.0;
+	}
+	if (around->reference != around->reference)
+		around->reference = first_rise;
+
+	return;
+}
+
+// Measures a waveform (samples from index 0, as left by
+// oXs_trace_buffer_copy_window). Channel 1 is measured first: the delays of
+// the other channels are those of their rising edges nearest to its first
+// rising edge, and their phases are the delays in units of its period.
+void oXs_measure_add(WaveformMeasure* measure, const TraceBuffer* waveform)
+{
+	unsigned int n = waveform->count;
+	double frequency = NAN;
+	EdgesAround around = {NAN, NAN, NAN};
+	for (unsigned int c = 0; c < measure->nr_channels; c++) {
+		double result[MEAS_QUANTITIES];
+		float lo = INFINITY, hi = -INFINITY;
+		measure->extrema(waveform->samples[c], n, &lo, &hi);
+		around.before = around.after = NAN;
+		oXs_measure_channel(measure, waveform->samples[c], n, lo, hi, result, &around);
+		if (c == 0) {
+			frequency = result[MEAS_FREQUENCY];
+		} else if ((around.reference == around.reference) && ((around.before == around.before) || (around.after == around.after))) {
+			double before = around.reference - around.before, after = around.after - around.reference;
+			double delay;
+			if (after != after)
+				delay = -before;
+			else if (before != before)
+				delay = after;
+			else
+				delay = (after <= before)? after : -before;
+			result[MEAS_DELAY] = delay * measure->dt;
+			if (frequency == frequency)
+				result[MEAS_PHASE] = 360.0 * result[MEAS_DELAY] * frequency;
+		}
+		for (unsigned int q = 0; q < MEAS_QUANTITIES; q++) {
+			if (result[q] == result[q]) {
+				measure->sum[c][q] += result[q];
+				measure->taken[c][q]++;
+			}
+		}
+	}
+	measure->count++;
+
+	return;
+}
+
+// Turns the averages of the measurements taken since the latest reading
+// into the current reading, and starts over.
+void oXs_measure_read(WaveformMeasure* measure)
+{
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++) {
+		for (unsigned int q = 0; q < MEAS_QUANTITIES; q++) {
+			if (measure->count > 0)
+				measure->value[c][q] = (measure->taken[c][q] > 0)? measure->sum[c][q] / measure->taken[c][q] : NAN;
+			measure->sum[c][q] = 0.0;
+			measure->taken[c][q] = 0;
+		}
+	}
+	measure->count = 0;
+
+	return;
+}
+
+// Writes value with an SI prefix and unit, or "---" if undefined.
+static void oXs_measure_format(char* text, double value, const char* unit)
+{
+	static const char* prefixes[] = {"n", "u", "m", "", "k", "M"};
+	if (value != value) {
+		sprintf(text, "---");
+		return;
+	}
+	int p = 3;
+	double magnitude = fabs(value);
+	while ((p > 0) && (magnitude > 0.0) && (magnitude < 1.0)) {
+		magnitude *= 1000.0;
+		value *= 1000.0;
+		p--;
+	}
+	while ((p < 5) && (magnitude >= 1000.0)) {
+		magnitude /= 1000.0;
+		value /= 1000.0;
+		p++;
+	}
+	sprintf(text, "%.4g %s%s", value, prefixes[p], unit);
+
+	return;
+}
+
+static void oXs_measure_format_fixed(char* text, double value, const char* unit)
+{
+	if (value != value)
+		sprintf(text, "---");
+	else
+		sprintf(text, "%.1f%s", value, unit);
+
+	return;
+}
+
+// One line per channel at the top left of the screen, in the channel's
+// color order.
+void oXs_measure_labels(const WaveformMeasure* measure, std::vector<std::string> & labels)
+{
+	char f[32], period[32], duty[32], rise[32], fall[32], overshoot[32], delay[32], phase[32];
+	char label[384];
+
+	labels.clear();
+	for (unsigned int c = 0; c < measure->nr_channels; c++) {
+		const double* v = measure->value[c];
+		oXs_measure_format(f, v[MEAS_FREQUENCY], "Hz");
+		oXs_measure_format(period, v[MEAS_PERIOD], "s");
+		oXs_measure_format(rise, v[MEAS_RISE], "s");
+		oXs_measure_format(fall, v[MEAS_FALL], "s");
+		oXs_measure_format_fixed(duty, v[MEAS_DUTY], "%");
+		oXs_measure_format_fixed(overshoot, v[MEAS_OVERSHOOT], "%");
+		int length = sprintf(label, "label %u \"Ch%u  f %s  T %s  duty %s  rise %s  fall %s  ovs %s", c + 1, c + 1, f, period, duty, rise, fall, overshoot);
+		if (c > 0) {
+			oXs_measure_format(delay, v[MEAS_DELAY], "s");
+			oXs_measure_format_fixed(phase, v[MEAS_PHASE], " deg");
+			length += sprintf(label + length, "  delay %s  phase %s", delay, phase);
+		}
+		sprintf(label + length, "\" at graph 0.01, graph %g left textcolor rgb '#d0d0d0' font \"mbfont:Courier,9\" front", 0.97 - 0.04 * c);
+		labels.push_back(label);
+	}
+
+	return;
+}
@@ -0,0 +1,77 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_MEASURE_H
+#define XOSCILLOSCOPE_ENGINE_MEASURE_H
+
+#include <vector>
+#include <string>
+
+#include "xoscilloscope-engine_buffer.h"
+#include "xoscilloscope-engine_envelope.h"
+
+#define MEASURE_HISTOGRAM_BINS 64
+
+// Frequency (Hz), period (s), duty cycle (%), 10-90% rise and fall times
+// (s) and overshoot (%) of each channel; delay (s) and phase (degrees) of
+// each channel with respect to channel 1.
+enum measure_quantity : unsigned int {
+	MEAS_FREQUENCY,
+	MEAS_PERIOD,
+	MEAS_DUTY,
+	MEAS_RISE,
+	MEAS_FALL,
+	MEAS_OVERSHOOT,
+	MEAS_DELAY,
+	MEAS_PHASE,
+	MEAS_QUANTITIES
+};
+
+// Automatic measurements of triggered analog waveforms, taken in two passes
+// over each waveform: the extrema first (with the peak-detect kernel), then
+// a scalar pass that follows the crossings of the 10%, 50% and 90% levels
+// between them and fills a histogram of the samples, whose most frequent
+// values in the upper and lower halves (the outermost ones, in case of
+// ties) are the top and base levels used for the overshoot. Measurements
+// are averaged over the waveforms added since the latest reading; those
+// that cannot be taken on a waveform (e.g. the frequency, with less than
+// two rising edges) are left out of the average, and are NaN in a reading
+// if never taken.
+struct WaveformMeasure {
+	ExtremaKernel		extrema;
+	unsigned int		nr_channels;
+	double			dt;
+	unsigned long		count;
+	double			sum[MAX_CHANNELS][MEAS_QUANTITIES];
+	unsigned long		taken[MAX_CHANNELS][MEAS_QUANTITIES];
+	double			value[MAX_CHANNELS][MEAS_QUANTITIES];
+	std::vector<unsigned int>	histogram;
+};
+
+void oXs_measure_reset(WaveformMeasure*, unsigned int, double);
+void oXs_measure_add(WaveformMeasure*, const TraceBuffer*);
+void oXs_measure_read(WaveformMeasure*);
+void oXs_measure_labels(const WaveformMeasure*, std::vector<std::string> &);
+
+#endif
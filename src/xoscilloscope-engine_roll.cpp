@@ -0,0 +1,180 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <cmath>
+#include <fstream>
+
+#include "xoscilloscope-engine_gnuplot.h"
+#include "xoscilloscope-engine_roll.h"
+
+void oXs_roll_display_reset(RollDisplay* roll, unsigned int nr_channels, unsigned int trace_size, double dt, double tdiv, const double* scale)
+{
+	roll->nr_channels = nr_channels;
+	roll->decimation = (trace_size + ROLL_BUCKETS - 1) / ROLL_BUCKETS;
+	if (roll->decimation < 1)
+		roll->decimation = 1;
+	roll->bucket_fill = 0;
+	roll->bucket_start = 0;
+	roll->dt = dt;
+	roll->tdiv = tdiv;
+	roll->time_span = trace_size * dt;
+	for (unsigned int c = 0; c < nr_channels; c++)
+		roll->scale[c] = scale[c];
+	roll->screen.clear();
+	roll->fresh.clear();
+	roll->file_rows = 0;
+
+	return;
+}
+
+static void oXs_roll_display_emit(RollDisplay* roll, const float* values, double t)
+{
+	std::vector<double> row(roll->nr_channels + 1);
+	row[0] = t;
+	for (unsigned int c = 0; c < roll->nr_channels; c++)
+		row[c + 1] = (values == NULL)? NAN : values[c] * roll->scale[c];
+	roll->fresh.push_back(row);
+	roll->screen.push_back(row);
+	while (roll->screen.size() > 2 * ROLL_BUCKETS + 2)
+		roll->screen.pop_front();
+
+	return;
+}
+
+static void oXs_roll_display_close_bucket(RollDisplay* roll)
+{
+	double t = roll->bucket_start * roll->dt;
+	oXs_roll_display_emit(roll, roll->minimum, t);
+	oXs_roll_display_emit(roll, roll->maximum, t);
+	roll->bucket_start += roll->bucket_fill;
+	roll->bucket_fill = 0;
+
+	return;
+}
+
+// Lost frames close the current bucket early, and are marked by a row of
+// NaN values, which breaks the traces.
+void oXs_roll_display_push_block(RollDisplay* roll, const PeriodBlock* block)
+{
+	if (block->gap_frames > 0) {
+		if (roll->bucket_fill > 0)
+			oXs_roll_display_close_bucket(roll);
+		oXs_roll_display_emit(roll, NULL, roll->bucket_start * roll->dt);
+		roll->bucket_start += block->gap_frames;
+	}
+
+	unsigned int j = 0;
+	while (j < block->size) {
+		unsigned int n = roll->decimation - roll->bucket_fill;
+		if (n > block->size - j)
+			n = block->size - j;
+		for (unsigned int c = 0; c < roll->nr_channels; c++) {
+			const float* x = block->samples[c] + j;
+			float lo = (roll->bucket_fill == 0)? x[0] : roll->minimum[c];
+			float hi = (roll->bucket_fill == 0)? x[0] : roll->maximum[c];
+			for (unsigned int i = 0; i < n; i++) {
+				lo = (x[i] < lo)? x[i] : lo;
+				hi = (x[i] > hi)? x[i] : hi;
+			}
+			roll->minimum[c] = lo;
+			roll->maximum[c] = hi;
+		}
+		roll->bucket_fill += n;
+		j += n;
+		if (roll->bucket_fill == roll->decimation)
+			oXs_roll_display_close_bucket(roll);
+	}
+
+	return;
+}
+
+// Keeps the graticule still while the traces scroll: the horizontal range
+// always ends at the most recent bucket.
+static void oXs_roll_display_set_range(FILE* gnuplot_pipe, RollDisplay* roll)
+{
+	char range[128];
+	std::vector< std::vector<double> > dummy;
+	double t_end = roll->bucket_start * roll->dt;
+	if (t_end < roll->time_span)
+		t_end = roll->time_span;
+	double t_begin = t_end - roll->time_span;
+
+	sprintf(range, "xrange [%f:%f]", t_begin, t_end);
+	GnuplotInterface(gnuplot_pipe, ROLL_FILE, "set", range, dummy);
+	sprintf(range, "xtics %f, %f, %f format \"\"", t_begin, roll->tdiv, t_end);
+	GnuplotInterface(gnuplot_pipe, ROLL_FILE, "set", range, dummy);
+
+	return;
+}
+
+static void oXs_roll_display_write(const std::vector<double>& row, std::ofstream& data)
+{
+	data << row[0];
+	for (unsigned int m = 1; m < row.size(); m++)
+		data << "\t" << row[m];
+	data << "\n";
+
+	return;
+}
+
+// Rewrites the data file with the last screen, and issues the plot command.
+void oXs_roll_display_plot(FILE* gnuplot_pipe, RollDisplay* roll, const std::string& plot_command)
+{
+	std::vector< std::vector<double> > dummy;
+	std::ofstream data(ROLL_FILE, std::ofstream::trunc);
+	for (unsigned int n = 0; n < roll->screen.size(); n++)
+		oXs_roll_display_write(roll->screen[n], data);
+	data.close();
+	roll->file_rows = roll->screen.size();
+	roll->fresh.clear();
+
+	oXs_roll_display_set_range(gnuplot_pipe, roll);
+	std::string command = "plot \"" ROLL_FILE "\" " + plot_command;
+	GnuplotInterface(gnuplot_pipe, ROLL_FILE, "execute", command.c_str(), dummy);
+
+	return;
+}
+
+// Appends the rows completed since the previous refresh and scrolls.
+void oXs_roll_display_refresh(FILE* gnuplot_pipe, RollDisplay* roll)
+{
+	std::vector< std::vector<double> > dummy;
+	if (roll->file_rows + roll->fresh.size() > 4 * ROLL_BUCKETS) {
+		std::ofstream data(ROLL_FILE, std::ofstream::trunc);
+		for (unsigned int n = 0; n < roll->screen.size(); n++)
+			oXs_roll_display_write(roll->screen[n], data);
+		roll->file_rows = roll->screen.size();
+	} else {
+		std::ofstream data(ROLL_FILE, std::ofstream::app);
+		for (unsigned int n = 0; n < roll->fresh.size(); n++)
+			oXs_roll_display_write(roll->fresh[n], data);
+		roll->file_rows += roll->fresh.size();
+	}
+	roll->fresh.clear();
+
+	oXs_roll_display_set_range(gnuplot_pipe, roll);
+	GnuplotInterface(gnuplot_pipe, ROLL_FILE, "execute", "rep", dummy);
+
+	return;
+}
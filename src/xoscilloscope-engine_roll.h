@@ -0,0 +1,69 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_ROLL_H
+#define XOSCILLOSCOPE_ENGINE_ROLL_H
+
+#include <cstdio>
+#include <deque>
+#include <vector>
+#include <string>
+
+#include "xoscilloscope-engine_buffer.h"
+
+#define ROLL_MIN_TDIV 0.5
+#define ROLL_BUCKETS 700
+#define ROLL_FILE "scope.roll"
+
+// Strip-chart display for slow time scales: new samples enter at the right
+// edge of the screen and the traces scroll to the left, without waiting for
+// a whole trace nor for a trigger. Samples are reduced on the fly to the
+// minimum and the maximum of each bucket of `decimation` samples, i.e. to
+// two rows per bucket, ROLL_BUCKETS buckets spanning the screen. Gnuplot
+// reads the rows from a regular file: on each refresh, only the rows of
+// the buckets completed in the meantime are appended to it, and the file is
+// rewritten with the last screen only once it holds two screens. Time is
+// counted from the start of the roll, lost frames included.
+struct RollDisplay {
+	unsigned int	nr_channels;
+	unsigned int	decimation;
+	unsigned int	bucket_fill;
+	unsigned long	bucket_start;
+	double		dt;
+	double		tdiv;
+	double		time_span;
+	double		scale[MAX_CHANNELS];
+	float		minimum[MAX_CHANNELS];
+	float		maximum[MAX_CHANNELS];
+	std::deque< std::vector<double> >	screen;
+	std::vector< std::vector<double> >	fresh;
+	unsigned long	file_rows;
+};
+
+void oXs_roll_display_reset(RollDisplay*, unsigned int, unsigned int, double, double, const double*);
+void oXs_roll_display_push_block(RollDisplay*, const PeriodBlock*);
+void oXs_roll_display_plot(FILE*, RollDisplay*, const std::string&);
+void oXs_roll_display_refresh(FILE*, RollDisplay*);
+
+#endif
@@ -0,0 +1,401 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <algorithm>
+#include <thread>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "xoscilloscope-engine_source.h"
+
+AcquisitionSource::AcquisitionSource()
+{
+	format = SND_PCM_FORMAT_S16_LE;
+	nr_channels = 2;
+	sample_rate = 0;
+	period_size = 0;
+	buffer_size = 0;
+	pace_realtime = true;
+	deadline_started = false;
+}
+
+void AcquisitionSource::waitPeriodDeadline()
+{
+	if (!this->pace_realtime)
+		return;
+	if (!this->deadline_started) {
+		this->deadline = std::chrono::steady_clock::now();
+		this->deadline_started = true;
+	}
+	this->deadline += std::chrono::nanoseconds((long long) (1e9 * this->period_size / (double) this->sample_rate));
+	std::this_thread::sleep_until(this->deadline);
+
+	return;
+}
+
+AlsaSource::AlsaSource(const std::string& device_name, snd_pcm_access_t requested_access, snd_pcm_format_t requested_format, unsigned int channels, unsigned int rate, unsigned int period, unsigned int buffer)
+{
+	this->format = requested_format;
+	this->nr_channels = channels;
+	this->sample_rate = rate;
+	this->period_size = period;
+	this->buffer_size = buffer;
+	this->access = requested_access;
+	if (snd_pcm_open(&(this->device_handle), device_name.c_str(), SND_PCM_STREAM_CAPTURE, 0) < 0) {
+		std::cerr <<  "Could not open audio device <" << device_name << ">\n",
+		exit(1);
+	}
+	this->setupHardware();
+	this->description = "ALSA device <" + device_name + ">, ";
+	this->description += (this->access == SND_PCM_ACCESS_MMAP_INTERLEAVED)? "mmap access, " : "read/write access, ";
+	this->description += snd_pcm_format_name(this->format);
+}
+
+AlsaSource::~AlsaSource()
+{
+	snd_pcm_close(this->device_handle);
+}
+
+int AlsaSource::setupHardware()
+{
+	int err;
+	snd_pcm_t *device_handle = this->device_handle;
+	snd_pcm_hw_params_t *device_parameters;
+	if (snd_pcm_hw_params_malloc(&device_parameters) < 0) {
+		std::cerr <<  "Could not allocate hardware parameter structure\n";
+		exit(1);
+	}
+	if ((err = snd_pcm_hw_params_any(device_handle, device_parameters)) < 0) {
+		std::cerr <<  "cannot initialize hardware parameter structure\n";
+		exit(1);
+	}
+	if (this->access == SND_PCM_ACCESS_MMAP_INTERLEAVED) {
+		if ((err = snd_pcm_hw_params_set_access(device_handle, device_parameters, SND_PCM_ACCESS_MMAP_INTERLEAVED)) < 0) {
+			std::cerr <<  " mmap access refused, falling back to read/write access...";
+			this->access = SND_PCM_ACCESS_RW_INTERLEAVED;
+		}
+	}
+	if (this->access == SND_PCM_ACCESS_RW_INTERLEAVED) {
+		if ((err = snd_pcm_hw_params_set_access(device_handle, device_parameters, SND_PCM_ACCESS_RW_INTERLEAVED)) < 0) {
+			std::cerr <<  "cannot set access type\n";
+			exit(1);
+		}
+	}
+	if (this->format == SND_PCM_FORMAT_UNKNOWN) {
+		// Automatic choice: the widest format the device offers.
+		const snd_pcm_format_t candidates[] = {SND_PCM_FORMAT_S32_LE, SND_PCM_FORMAT_S24_3LE, SND_PCM_FORMAT_FLOAT_LE, SND_PCM_FORMAT_S16_LE};
+		this->format = SND_PCM_FORMAT_S16_LE;
+		for (unsigned int k = 0; k < sizeof(candidates) / sizeof(candidates[0]); k++) {
+			if (snd_pcm_hw_params_test_format(device_handle, device_parameters, candidates[k]) == 0) {
+				this->format = candidates[k];
+				break;
+			}
+		}
+	}
+	if ((err = snd_pcm_hw_params_set_format(device_handle, device_parameters, this->format)) < 0) {
+		std::cerr <<  "cannot set sample format " << snd_pcm_format_name(this->format) << "\n";
+		exit(1);
+	}
+	if ((err = snd_pcm_hw_params_set_rate_near(device_handle, device_parameters, &(this->sample_rate), 0)) < 0) {
+		std::cerr <<  "cannot set sample rate\n";
+		exit(1);
+	}
+	if ((err = snd_pcm_hw_params_set_channels_near(device_handle, device_parameters, &(this->nr_channels))) < 0) {
+		std::cerr <<  "cannot set channel count\n";
+		exit(1);
+	}
+	snd_pcm_uframes_t frames = this->period_size;
+	if ((err = snd_pcm_hw_params_set_period_size_near(device_handle, device_parameters, &frames, 0)) < 0) {
+		std::cerr <<  "cannot set period size\n";
+		exit(1);
+	}
+	frames = this->buffer_size;
+	if ((frames > 0) && ((err = snd_pcm_hw_params_set_buffer_size_near(device_handle, device_parameters, &frames)) < 0)) {
+		std::cerr <<  "cannot set buffer size\n";
+		exit(1);
+	}
+	if ((err = snd_pcm_hw_params(device_handle, device_parameters)) < 0) {
+		std::cerr <<  "cannot set parameters\n";
+		exit(1);
+	}
+	snd_pcm_hw_params_get_rate(device_parameters, &(this->sample_rate), 0);
+	snd_pcm_hw_params_get_channels(device_parameters, &(this->nr_channels));
+	snd_pcm_hw_params_get_period_size(device_parameters, &frames, 0);
+	this->period_size = frames;
+	snd_pcm_hw_params_get_buffer_size(device_parameters, &frames);
+	this->buffer_size = frames;
+	snd_pcm_hw_params_free(device_parameters);
+	snd_pcm_nonblock(device_handle, 0);
+	if ((err = snd_pcm_prepare(device_handle)) < 0) {
+		std::cerr <<  "cannot prepare audio interface for use\n";
+		exit(1);
+	}
+
+	return 0;
+}
+
+// Read/write access: snd_pcm_readi writes whole periods straight into the
+// capture ring.
+snd_pcm_sframes_t AlsaSource::readPeriod(unsigned char* dest)
+{
+	const unsigned int frame_bytes = this->frameBytes();
+	snd_pcm_uframes_t nr_done = 0;
+	while (nr_done < this->period_size) {
+		snd_pcm_sframes_t nr_read = snd_pcm_readi(this->device_handle, dest + nr_done * frame_bytes, this->period_size - nr_done);
+		if (nr_read < 0)
+			return nr_read;
+		nr_done += nr_read;
+	}
+
+	return nr_done;
+}
+
+// Overruns (-EPIPE) and suspends (-ESTRPIPE) leave the device stopped: it is
+// prepared again, and restarted by the next read (or explicitly, for mmap
+// access, by convertPeriod). Any other error is returned unchanged.
+int AlsaSource::recover(int err)
+{
+	return snd_pcm_recover(this->device_handle, err, 1);
+}
+
+// mmap access: the conversion kernel reads each chunk of the period
+// straight from the DMA area, which is handed back to the device only once
+// converted; the chunk ends where the device buffer wraps around.
+snd_pcm_sframes_t AlsaSource::convertPeriod(DeinterleaveKernel deinterleave, PeriodBlock* block)
+{
+	const snd_pcm_channel_area_t *areas;
+	snd_pcm_uframes_t offset, nr_frames;
+	snd_pcm_uframes_t nr_done = 0;
+	int err;
+
+	if (snd_pcm_state(this->device_handle) == SND_PCM_STATE_PREPARED) {
+		if ((err = snd_pcm_start(this->device_handle)) < 0)
+			return err;
+	}
+	while (nr_done < this->period_size) {
+		snd_pcm_sframes_t avail = snd_pcm_avail_update(this->device_handle);
+		if (avail < 0)
+			return avail;
+		if (avail == 0) {
+			if ((err = snd_pcm_wait(this->device_handle, 1000)) < 0)
+				return err;
+			continue;
+		}
+		nr_frames = this->period_size - nr_done;
+		if ((err = snd_pcm_mmap_begin(this->device_handle, &areas, &offset, &nr_frames)) < 0)
+			return err;
+		const unsigned char* dma = (const unsigned char *) areas[0].addr + areas[0].first / 8 + offset * (areas[0].step / 8);
+		PeriodBlock chunk = *block;
+		for (unsigned int c = 0; c < block->nr_channels; c++)
+			chunk.samples[c] = block->samples[c] + nr_done;
+		deinterleave(dma, &chunk, nr_frames, this->nr_channels);
+		snd_pcm_sframes_t nr_committed = snd_pcm_mmap_commit(this->device_handle, offset, nr_frames);
+		if (nr_committed < 0)
+			return nr_committed;
+		nr_done += nr_committed;
+	}
+	block->size = nr_done;
+
+	return nr_done;
+}
+
+static uint32_t oXs_read_le32(const unsigned char* p)
+{
+	return (uint32_t) p[0] | ((uint32_t) p[1] << 8) | ((uint32_t) p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+static uint16_t oXs_read_le16(const unsigned char* p)
+{
+	return (uint16_t) (p[0] | (p[1] << 8));
+}
+
+FileSource::FileSource(const std::string& file_name, snd_pcm_format_t raw_format, unsigned int raw_channels, bool realtime, unsigned int rate, unsigned int period)
+{
+	this->sample_rate = rate;
+	this->period_size = period;
+	this->buffer_size = period;
+	this->pace_realtime = realtime;
+	this->position = 0;
+
+	int fd = open(file_name.c_str(), O_RDONLY);
+	struct stat file_status;
+	if ((fd < 0) || (fstat(fd, &file_status) < 0)) {
+		std::cerr << "Could not open input file <" << file_name << ">\n";
+		exit(1);
+	}
+	this->mapped_size = file_status.st_size;
+	this->mapped_file = mmap(NULL, this->mapped_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (this->mapped_file == MAP_FAILED) {
+		std::cerr << "Could not map input file <" << file_name << ">\n";
+		exit(1);
+	}
+	madvise(this->mapped_file, this->mapped_size, MADV_SEQUENTIAL);
+
+	const unsigned char* bytes = (const unsigned char *) this->mapped_file;
+	if ((this->mapped_size >= 12) && !memcmp(bytes, "RIFF", 4) && !memcmp(bytes + 8, "WAVE", 4)) {
+		size_t k = 12;
+		bool format_found = false;
+		this->first_frame = NULL;
+		while (k + 8 <= this->mapped_size) {
+			uint32_t chunk_size = oXs_read_le32(bytes + k + 4);
+			if (!memcmp(bytes + k, "fmt ", 4) && (chunk_size >= 16)) {
+				uint16_t wav_format = oXs_read_le16(bytes + k + 8);
+				this->nr_channels = oXs_read_le16(bytes + k + 10);
+				this->sample_rate = oXs_read_le32(bytes + k + 12);
+				uint16_t bits = oXs_read_le16(bytes + k + 22);
+				if ((wav_format == 0xfffe) && (chunk_size >= 40))
+					wav_format = oXs_read_le16(bytes + k + 32);
+				if ((wav_format == 1) && (bits == 16)) {
+					this->format = SND_PCM_FORMAT_S16_LE;
+				} else if ((wav_format == 1) && (bits == 24)) {
+					this->format = SND_PCM_FORMAT_S24_3LE;
+				} else if ((wav_format == 1) && (bits == 32)) {
+					this->format = SND_PCM_FORMAT_S32_LE;
+				} else if ((wav_format == 3) && (bits == 32)) {
+					this->format = SND_PCM_FORMAT_FLOAT_LE;
+				} else {
+					std::cerr << "Unsupported WAV file <" << file_name << ">: only 16/24/32-bit integer and 32-bit float PCM are supported\n";
+					exit(1);
+				}
+				if ((this->nr_channels < 1) || (this->sample_rate == 0)) {
+					std::cerr << "Malformed WAV file <" << file_name << ">\n";
+					exit(1);
+				}
+				format_found = true;
+			} else if (!memcmp(bytes + k, "data", 4)) {
+				size_t data_size = (k + 8 + chunk_size > this->mapped_size)? this->mapped_size - k - 8 : chunk_size;
+				this->first_frame = bytes + k + 8;
+				this->nr_frames = (format_found)? data_size / this->frameBytes() : 0;
+				break;
+			}
+			k += 8 + chunk_size + (chunk_size & 1);
+		}
+		if (!format_found || (this->first_frame == NULL)) {
+			std::cerr << "Malformed WAV file <" << file_name << ">\n";
+			exit(1);
+		}
+		this->description = "WAV file <" + file_name + ">, " + snd_pcm_format_name(this->format);
+	} else {
+		this->format = (raw_format == SND_PCM_FORMAT_UNKNOWN)? SND_PCM_FORMAT_S16_LE : raw_format;
+		this->nr_channels = raw_channels;
+		this->first_frame = bytes;
+		this->nr_frames = this->mapped_size / this->frameBytes();
+		this->description = "raw " + std::string(snd_pcm_format_name(this->format)) + " file <" + file_name + ">";
+	}
+	if (this->nr_frames == 0) {
+		std::cerr << "Input file <" << file_name << "> contains no samples\n";
+		exit(1);
+	}
+	this->description += (this->pace_realtime)? ", real-time replay" : ", free-running replay";
+}
+
+FileSource::~FileSource()
+{
+	munmap(this->mapped_file, this->mapped_size);
+}
+
+snd_pcm_sframes_t FileSource::readPeriod(unsigned char* dest)
+{
+	const unsigned int frame_bytes = this->frameBytes();
+	unsigned long nr_done = 0;
+	while (nr_done < this->period_size) {
+		unsigned long nr_copy = std::min((unsigned long) this->period_size - nr_done, this->nr_frames - this->position);
+		memcpy(dest + nr_done * frame_bytes, this->first_frame + this->position * frame_bytes, nr_copy * frame_bytes);
+		nr_done += nr_copy;
+		this->position += nr_copy;
+		if (this->position == this->nr_frames)
+			this->position = 0;
+	}
+	this->waitPeriodDeadline();
+
+	return this->period_size;
+}
+
+SynthSource::SynthSource(double f1, double f2, snd_pcm_format_t requested_format, unsigned int channels, bool realtime, unsigned int rate, unsigned int period)
+{
+	this->nr_channels = channels;
+	this->format = (requested_format == SND_PCM_FORMAT_UNKNOWN)? SND_PCM_FORMAT_S16_LE : requested_format;
+	this->sample_rate = rate;
+	this->period_size = period;
+	this->buffer_size = period;
+	this->pace_realtime = realtime;
+	this->phase_1 = 0.0;
+	this->phase_2 = 0.0;
+	this->step_1 = f1 / (double) rate;
+	this->step_2 = f2 / (double) rate;
+	this->noise_state = 12345;
+
+	char text[128];
+	sprintf(text, "synthesizer (%g Hz sine, %g Hz square), %s, %s", f1, f2, snd_pcm_format_name(this->format), (realtime)? "real-time" : "free-running");
+	this->description = text;
+}
+
+snd_pcm_sframes_t SynthSource::readPeriod(unsigned char* dest)
+{
+	const double two_pi = 8.0 * atan(1.0);
+	const unsigned int width = oXs_format_width(this->format);
+	for (unsigned int i = 0; i < this->period_size; i++) {
+		this->noise_state = this->noise_state * 1664525u + 1013904223u;
+		int noise = (int) (this->noise_state >> 24) - 128;
+		unsigned char* frame = dest + i * this->nr_channels * width;
+		oXs_encode_sample(frame, this->format, 8000.0 * sin(two_pi * this->phase_1) + noise);
+		if (this->nr_channels > 1)
+			oXs_encode_sample(frame + width, this->format, ((this->phase_2 < 0.5)? 6000 : -6000) + noise);
+		for (unsigned int c = 2; c < this->nr_channels; c++)
+			oXs_encode_sample(frame + c * width, this->format, 4000.0 * sin(two_pi * (this->phase_1 - c / 8.0)) + noise);
+		this->phase_1 += this->step_1;
+		if (this->phase_1 >= 1.0)
+			this->phase_1 -= 1.0;
+		this->phase_2 += this->step_2;
+		if (this->phase_2 >= 1.0)
+			this->phase_2 -= 1.0;
+	}
+	this->waitPeriodDeadline();
+
+	return this->period_size;
+}
+
+// Source specifications: "alsa" (default), "file:<path>", "synth[:f1[,f2]]".
+AcquisitionSource* oXs_create_source(const std::string& source_spec, const std::string& device_name, snd_pcm_access_t access, snd_pcm_format_t format, unsigned int channels, bool realtime, unsigned int rate, unsigned int period, unsigned int buffer)
+{
+	if (source_spec == "alsa") {
+		return new AlsaSource(device_name, access, format, channels, rate, period, buffer);
+	} else if (source_spec.compare(0, 5, "file:") == 0) {
+		return new FileSource(source_spec.substr(5), format, channels, realtime, rate, period);
+	} else if (source_spec.compare(0, 5, "synth") == 0) {
+		double f1 = 1000.0, f2 = 250.0;
+		if (source_spec.size() > 6)
+			sscanf(source_spec.c_str() + 6, "%lf,%lf", &f1, &f2);
+		return new SynthSource(f1, f2, format, channels, realtime, rate, period);
+	}
+	std::cerr << "Unknown acquisition source '" << source_spec << "' (use 'alsa', 'file:<path>' or 'synth[:f1[,f2]]').\n";
+	exit(1);
+}
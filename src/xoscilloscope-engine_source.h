@@ -0,0 +1,128 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_SOURCE_H
+#define XOSCILLOSCOPE_ENGINE_SOURCE_H
+
+#include <cstdint>
+#include <string>
+#include <chrono>
+#include <alsa/asoundlib.h>
+
+#include "xoscilloscope-engine_buffer.h"
+#include "xoscilloscope-engine_format.h"
+
+// An acquisition source delivers interleaved frames of nr_channels samples
+// in the given format, one period at a time, to the capture thread. Live
+// sources (sound cards) cannot be paused, so the capture thread drops their
+// periods when the ring is full; replayed and synthetic sources are instead
+// throttled by the ring. When readPeriod fails, the capture thread hands
+// the error to recover(), which returns a negative code if the source
+// cannot be restarted. Mapped sources deliver converted periods instead,
+// through convertPeriod, running the conversion kernel on their own memory.
+class AcquisitionSource
+{
+public:
+	AcquisitionSource();
+	virtual ~AcquisitionSource(){}
+	virtual snd_pcm_sframes_t readPeriod(unsigned char*) = 0;
+	virtual snd_pcm_sframes_t convertPeriod(DeinterleaveKernel, PeriodBlock*) { return -ENOSYS; }
+	virtual bool isMapped() { return false; }
+	virtual int recover(int err) { return err; }
+	virtual bool isLive() { return false; }
+	unsigned int frameBytes() { return this->nr_channels * oXs_format_width(this->format); }
+
+	snd_pcm_format_t	format;
+	unsigned int	nr_channels;
+	unsigned int	sample_rate;
+	unsigned int	period_size;
+	unsigned int	buffer_size;
+	bool		pace_realtime;
+	std::string	description;
+
+protected:
+	void waitPeriodDeadline();
+
+	bool					deadline_started;
+	std::chrono::steady_clock::time_point	deadline;
+};
+
+class AlsaSource : public AcquisitionSource
+{
+public:
+	AlsaSource(const std::string&, snd_pcm_access_t, snd_pcm_format_t, unsigned int, unsigned int, unsigned int, unsigned int);
+	virtual ~AlsaSource();
+	virtual snd_pcm_sframes_t readPeriod(unsigned char*);
+	virtual snd_pcm_sframes_t convertPeriod(DeinterleaveKernel, PeriodBlock*);
+	virtual int recover(int);
+	virtual bool isLive() { return true; }
+	virtual bool isMapped() { return this->access == SND_PCM_ACCESS_MMAP_INTERLEAVED; }
+
+	snd_pcm_t*		device_handle;
+	snd_pcm_access_t	access;
+
+private:
+	int setupHardware();
+};
+
+// Replays a WAV file (16/24/32-bit integer or 32-bit float PCM), or a raw
+// interleaved file with the requested format and channel count, in a loop.
+// The file is memory-mapped, so replay costs one copy per period.
+class FileSource : public AcquisitionSource
+{
+public:
+	FileSource(const std::string&, snd_pcm_format_t, unsigned int, bool, unsigned int, unsigned int);
+	virtual ~FileSource();
+	virtual snd_pcm_sframes_t readPeriod(unsigned char*);
+
+private:
+	void*			mapped_file;
+	size_t			mapped_size;
+	const unsigned char*	first_frame;
+	unsigned long		nr_frames;
+	unsigned long		position;
+};
+
+// Deterministic test signal: a sine wave on channel 1, a square wave on
+// channel 2 and phase-shifted sine waves on further channels, all with a
+// small pseudo-random noise from a fixed-seed generator, so that every run
+// produces exactly the same samples. Samples are encoded in the requested
+// format, to exercise the conversion kernels.
+class SynthSource : public AcquisitionSource
+{
+public:
+	SynthSource(double, double, snd_pcm_format_t, unsigned int, bool, unsigned int, unsigned int);
+	virtual snd_pcm_sframes_t readPeriod(unsigned char*);
+
+private:
+	double		phase_1;
+	double		phase_2;
+	double		step_1;
+	double		step_2;
+	uint32_t	noise_state;
+};
+
+AcquisitionSource* oXs_create_source(const std::string&, const std::string&, snd_pcm_access_t, snd_pcm_format_t, unsigned int, bool, unsigned int, unsigned int, unsigned int);
+
+#endif
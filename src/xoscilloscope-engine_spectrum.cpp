@@ -0,0 +1,227 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <cmath>
+#include <algorithm>
+
+#include "xoscilloscope-engine_spectrum.h"
+
+// Tables are computed in double precision and stored as floats.
+void oXs_fft_plan(FftPlan* plan, unsigned int size)
+{
+	if ((plan->size == size) && !plan->re.empty())
+		return;
+	unsigned int m = size / 2;
+	unsigned int bits = 0;
+	while ((1u << bits) < m)
+		bits++;
+	plan->size = size;
+	plan->bit_reversal.resize(m);
+	for (unsigned int n = 0; n < m; n++) {
+		unsigned int r = 0;
+		for (unsigned int b = 0; b < bits; b++)
+			r |= ((n >> b) & 1) << (bits - 1 - b);
+		plan->bit_reversal[n] = r;
+	}
+	plan->twiddle_cos.resize(m / 2);
+	plan->twiddle_sin.resize(m / 2);
+	for (unsigned int j = 0; j < m / 2; j++) {
+		plan->twiddle_cos[j] = cos(2.0 * M_PI * j / m);
+		plan->twiddle_sin[j] = sin(2.0 * M_PI * j / m);
+	}
+	plan->split_cos.resize(m + 1);
+	plan->split_sin.resize(m + 1);
+	for (unsigned int k = 0; k <= m; k++) {
+		plan->split_cos[k] = cos(2.0 * M_PI * k / size);
+		plan->split_sin[k] = sin(2.0 * M_PI * k / size);
+	}
+	plan->re.resize(m);
+	plan->im.resize(m);
+
+	return;
+}
+
+// Power |X_k|^2 of the bins k = 0 ... size / 2 of the windowed sequence
+// x[n] w[n]. With z[n] = x[2n] + i x[2n+1] and Z its transform of size
+// m = size / 2, the even and odd halves are E_k = (Z_k + Z*_{m-k}) / 2 and
+// O_k = (Z_k - Z*_{m-k}) / 2i, and X_k = E_k + exp(-2 pi i k / size) O_k.
+void oXs_fft_power(FftPlan* plan, const float* x, const float* w, float* power)
+{
+	unsigned int m = plan->size / 2;
+	float* re = plan->re.data();
+	float* im = plan->im.data();
+	const unsigned int* bit_reversal = plan->bit_reversal.data();
+	for (unsigned int n = 0; n < m; n++) {
+		unsigned int r = bit_reversal[n];
+		re[r] = x[2 * n] * w[2 * n];
+		im[r] = x[2 * n + 1] * w[2 * n + 1];
+	}
+
+	const float* tc = plan->twiddle_cos.data();
+	const float* ts = plan->twiddle_sin.data();
+	for (unsigned int half = 1, step = m / 2; half < m; half *= 2, step /= 2) {
+		for (unsigned int i = 0; i < m; i += 2 * half) {
+			for (unsigned int j = 0; j < half; j++) {
+				float c = tc[j * step], s = ts[j * step];
+				unsigned int a = i + j, b = a + half;
+				float tr = c * re[b] + s * im[b];
+				float ti = c * im[b] - s * re[b];
+				re[b] = re[a] - tr;
+				im[b] = im[a] - ti;
+				re[a] += tr;
+				im[a] += ti;
+			}
+		}
+	}
+
+	const float* sc = plan->split_cos.data();
+	const float* ss = plan->split_sin.data();
+	for (unsigned int k = 0; k <= m; k++) {
+		unsigned int kk = (k == m)? 0 : k;
+		unsigned int mk = (k == 0)? 0 : m - k;
+		float er = 0.5f * (re[kk] + re[mk]), ei = 0.5f * (im[kk] - im[mk]);
+		float orr = 0.5f * (im[kk] + im[mk]), oi = -0.5f * (re[kk] - re[mk]);
+		float xr = er + sc[k] * orr + ss[k] * oi;
+		float xi = ei + sc[k] * oi - ss[k] * orr;
+		power[k] = xr * xr + xi * xi;
+	}
+
+	return;
+}
+
+// Periodic windows of size points, as sums of cosines; the flat-top window
+// reads the amplitude of a tone within 0.01 dB wherever it falls between
+// bins. Returns the sum of the window (its coherent gain times size).
+double oXs_spectrum_window(std::vector<float> & window, spectrum_window type, unsigned int size)
+{
+	static const double coefficients[3][5] = {
+		{0.5, 0.5, 0.0, 0.0, 0.0},
+		{0.42, 0.5, 0.08, 0.0, 0.0},
+		{0.21557895, 0.41663158, 0.277263158, 0.083578947, 0.006947368}
+	};
+	const double* a = coefficients[(type <= WIN_FLATTOP)? type : WIN_HANN];
+	double sum = 0.0;
+	window.resize(size);
+	for (unsigned int n = 0; n < size; n++) {
+		double phase = 2.0 * M_PI * n / size;
+		double w = a[0] - a[1] * cos(phase) + a[2] * cos(2.0 * phase) - a[3] * cos(3.0 * phase) + a[4] * cos(4.0 * phase);
+		window[n] = w;
+		sum += w;
+	}
+
+	return sum;
+}
+
+// The record is the largest power of two not exceeding the trace.
+unsigned int oXs_spectrum_size(unsigned int trace_size)
+{
+	unsigned int size = SPECTRUM_MIN_SIZE;
+	while ((size < SPECTRUM_MAX_SIZE) && (2 * size <= trace_size))
+		size *= 2;
+
+	return size;
+}
+
+void oXs_spectrum_reset(Spectrum* spectrum, unsigned int nr_channels, unsigned int size, spectrum_window window_type, spectrum_averaging averaging, unsigned int navg)
+{
+	oXs_fft_plan(&spectrum->plan, size);
+	if ((spectrum->size != size) || (spectrum->window_type != window_type) || spectrum->window.empty())
+		spectrum->gain = oXs_spectrum_window(spectrum->window, window_type, size);
+	spectrum->window_type = window_type;
+	spectrum->averaging = averaging;
+	spectrum->nr_channels = nr_channels;
+	spectrum->size = size;
+	spectrum->navg = (navg > 1)? navg : 1;
+	spectrum->count = 0;
+	spectrum->frame.resize(size / 2 + 1);
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++)
+		spectrum->power[c].assign((c < nr_channels)? size / 2 + 1 : 0, 0.0);
+
+	return;
+}
+
+// The record must hold exactly size samples, contiguous from index 0 (see
+// oXs_trace_buffer_copy_window). Power averages are exponential, with a
+// weight 1 / count until navg frames have been taken, so that the first
+// navg frames are averaged uniformly.
+void oXs_spectrum_add(Spectrum* spectrum, const TraceBuffer* record)
+{
+	if (record->count < spectrum->size)
+		return;
+	spectrum->count++;
+	double alpha = 1.0;
+	if (spectrum->averaging == SPEC_AVG_RMS)
+		alpha = 1.0 / std::min(spectrum->count, (unsigned long) spectrum->navg);
+	unsigned int nr_bins = spectrum->size / 2 + 1;
+	for (unsigned int c = 0; c < spectrum->nr_channels; c++) {
+		float* frame = spectrum->frame.data();
+		double* power = spectrum->power[c].data();
+		oXs_fft_power(&spectrum->plan, record->samples[c], spectrum->window.data(), frame);
+		if ((spectrum->averaging == SPEC_AVG_PEAK_HOLD) && (spectrum->count > 1)) {
+			for (unsigned int k = 0; k < nr_bins; k++)
+				power[k] = std::max(power[k], (double) frame[k]);
+		} else {
+			for (unsigned int k = 0; k < nr_bins; k++)
+				power[k] += alpha * (frame[k] - power[k]);
+		}
+	}
+
+	return;
+}
+
+// Writes at most SPECTRUM_MAX_POINTS rows, each the peak of a run of
+// adjacent bins, drawn at their centre frequency. Magnitudes are peak
+// amplitudes, scaled by k, or in dB (see oXs_spectrum_db).
+void oXs_spectrum_fill(const Spectrum* spectrum, std::vector< std::vector<double> > & gnuplot_data, unsigned int sample_rate, spectrum_scale scale, const double* k)
+{
+	unsigned int nr_bins = spectrum->size / 2 + 1;
+	unsigned int stride = (nr_bins + SPECTRUM_MAX_POINTS - 1) / SPECTRUM_MAX_POINTS;
+	unsigned int nr_rows = (nr_bins + stride - 1) / stride;
+	unsigned int nr_columns = spectrum->nr_channels + 1;
+	if ((gnuplot_data.size() != nr_rows) || (gnuplot_data[0].size() != nr_columns))
+		gnuplot_data.assign(nr_rows, std::vector<double>(nr_columns, 0.0));
+
+	double df = (double) sample_rate / spectrum->size;
+	for (unsigned int j = 0; j < nr_rows; j++) {
+		unsigned int last = std::min((j + 1) * stride, nr_bins) - 1;
+		gnuplot_data[j][0] = 0.5 * (j * stride + last) * df;
+	}
+	for (unsigned int c = 0; c < spectrum->nr_channels; c++) {
+		const double* power = spectrum->power[c].data();
+		for (unsigned int j = 0; j < nr_rows; j++) {
+			unsigned int first = j * stride;
+			unsigned int last = std::min(first + stride, nr_bins);
+			double peak = 0.0;
+			for (unsigned int i = first; i < last; i++) {
+				double amplitude = sqrt(power[i]) / spectrum->gain;
+				if ((i > 0) && (i < nr_bins - 1))
+					amplitude *= 2.0;
+				peak = std::max(peak, amplitude);
+			}
+			gnuplot_data[j][c + 1] = (scale == SCALE_LINEAR)? peak * k[c] : oXs_spectrum_db(peak, k[c]);
+		}
+	}
+
+	return;
+}
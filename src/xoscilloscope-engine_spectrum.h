@@ -0,0 +1,115 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_SPECTRUM_H
+#define XOSCILLOSCOPE_ENGINE_SPECTRUM_H
+
+#include <cmath>
+#include <vector>
+
+#include "xoscilloscope-engine_buffer.h"
+
+#define SPECTRUM_MIN_SIZE 64
+#define SPECTRUM_MAX_SIZE 65536
+#define SPECTRUM_MAX_POINTS 1024
+#define SPECTRUM_MAX_RATE 25.0
+#define SPECTRUM_FULL_SCALE 32768.0
+#define SPECTRUM_DB_PER_DIV 20.0
+#define SPECTRUM_DB_FLOOR -300.0
+
+enum spectrum_window : unsigned int {
+	WIN_HANN,
+	WIN_BLACKMAN,
+	WIN_FLATTOP
+};
+
+enum spectrum_scale : unsigned int {
+	SCALE_LINEAR,
+	SCALE_DB
+};
+
+// Spectra are averaged over the latest frames (the number of averages of
+// the console): power averaging (RMS of the magnitudes), or the maximum of
+// every bin since the last restart.
+enum spectrum_averaging : unsigned int {
+	SPEC_AVG_NONE,
+	SPEC_AVG_RMS,
+	SPEC_AVG_PEAK_HOLD
+};
+
+// Real FFT of size points (a power of two), computed as a complex FFT of
+// size / 2 points of the even and odd samples, followed by the split into
+// the spectrum of the real sequence. The bit-reversal permutation and the
+// twiddle factors of both steps are computed once, when the size changes;
+// re and im are the work arrays of the complex FFT.
+struct FftPlan {
+	unsigned int			size;
+	std::vector<unsigned int>	bit_reversal;
+	std::vector<float>		twiddle_cos;
+	std::vector<float>		twiddle_sin;
+	std::vector<float>		split_cos;
+	std::vector<float>		split_sin;
+	std::vector<float>		re;
+	std::vector<float>		im;
+};
+
+void oXs_fft_plan(FftPlan*, unsigned int);
+void oXs_fft_power(FftPlan*, const float*, const float*, float*);
+double oXs_spectrum_window(std::vector<float> &, spectrum_window, unsigned int);
+unsigned int oXs_spectrum_size(unsigned int);
+
+// Peak amplitude in dB, referred to 1 V RMS (dBV) for channels calibrated
+// at k volts per unit, and to the full scale of the converter (dBFS) for
+// uncalibrated ones (k = 1).
+inline double oXs_spectrum_db(double amplitude, double k)
+{
+	if (amplitude <= 0.0)
+		return SPECTRUM_DB_FLOOR;
+	double db = (k != 1.0)? 20.0 * log10(amplitude * k / M_SQRT2) : 20.0 * log10(amplitude / SPECTRUM_FULL_SCALE);
+	return (db > SPECTRUM_DB_FLOOR)? db : SPECTRUM_DB_FLOOR;
+}
+
+// Spectrum analyzer: the latest size samples of every channel are
+// windowed and transformed; power holds the power of the size / 2 + 1 bins
+// of each channel, averaged (or held) over count frames, and gain is the
+// sum of the window, which turns magnitudes into amplitudes.
+struct Spectrum {
+	FftPlan			plan;
+	spectrum_window		window_type;
+	spectrum_averaging	averaging;
+	std::vector<float>	window;
+	double			gain;
+	unsigned int		nr_channels;
+	unsigned int		size;
+	unsigned int		navg;
+	unsigned long		count;
+	std::vector<float>	frame;
+	std::vector<double>	power[MAX_CHANNELS];
+};
+
+void oXs_spectrum_reset(Spectrum*, unsigned int, unsigned int, spectrum_window, spectrum_averaging, unsigned int);
+void oXs_spectrum_add(Spectrum*, const TraceBuffer*);
+void oXs_spectrum_fill(const Spectrum*, std::vector< std::vector<double> > &, unsigned int, spectrum_scale, const double*);
+
+#endif
@@ -0,0 +1,525 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <iostream>
+#include <cmath>
+#include <cstdint>
+#include <chrono>
+#include <algorithm>
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+#endif
+
+#include "xoscilloscope-engine_trigger.h"
+
+static inline int oXs_find_crossing_scalar(const float* x, unsigned int n, float previous, float level, bool rising)
+{
+	float last = previous;
+	if (rising) {
+		for (unsigned int i = 0; i < n; i++) {
+			if ((last < level) && (x[i] >= level))
+				return i;
+			last = x[i];
+		}
+	} else {
+		for (unsigned int i = 0; i < n; i++) {
+			if ((last > level) && (x[i] <= level))
+				return i;
+			last = x[i];
+		}
+	}
+
+	return -1;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Vector kernels compare each sample, and the one before it (an unaligned
+// load shifted by one), against the level; the first set bit of the
+// movemask of both conditions is the crossing. All comparisons are ordered,
+// hence false for NaN. The first sample, whose predecessor is not in the
+// block, and the tail are handled by the scalar kernel.
+__attribute__((target("sse2")))
+static int oXs_find_crossing_sse2(const float* x, unsigned int n, float previous, float level, bool rising)
+{
+	if (n == 0)
+		return -1;
+	if (oXs_find_crossing_scalar(x, 1, previous, level, rising) == 0)
+		return 0;
+
+	const __m128 l = _mm_set1_ps(level);
+	unsigned int i = 1;
+	if (rising) {
+		for (; i + 4 <= n; i += 4) {
+			__m128 before = _mm_loadu_ps(x + i - 1);
+			__m128 now = _mm_loadu_ps(x + i);
+			int mask = _mm_movemask_ps(_mm_and_ps(_mm_cmplt_ps(before, l), _mm_cmpge_ps(now, l)));
+			if (mask)
+				return i + __builtin_ctz(mask);
+		}
+	} else {
+		for (; i + 4 <= n; i += 4) {
+			__m128 before = _mm_loadu_ps(x + i - 1);
+			__m128 now = _mm_loadu_ps(x + i);
+			int mask = _mm_movemask_ps(_mm_and_ps(_mm_cmpgt_ps(before, l), _mm_cmple_ps(now, l)));
+			if (mask)
+				return i + __builtin_ctz(mask);
+		}
+	}
+	int k = oXs_find_crossing_scalar(x + i, n - i, x[i - 1], level, rising);
+
+	return (k < 0)? -1 : (int) i + k;
+}
+
+__attribute__((target("avx2")))
+static int oXs_find_crossing_avx2(const float* x, unsigned int n, float previous, float level, bool rising)
+{
+	if (n == 0)
+		return -1;
+	if (oXs_find_crossing_scalar(x, 1, previous, level, rising) == 0)
+		return 0;
+
+	const __m256 l = _mm256_set1_ps(level);
+	unsigned int i = 1;
+	if (rising) {
+		for (; i + 8 <= n; i += 8) {
+			__m256 before = _mm256_loadu_ps(x + i - 1);
+			__m256 now = _mm256_loadu_ps(x + i);
+			int mask = _mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(before, l, _CMP_LT_OQ), _mm256_cmp_ps(now, l, _CMP_GE_OQ)));
+			if (mask)
+				return i + __builtin_ctz(mask);
+		}
+	} else {
+		for (; i + 8 <= n; i += 8) {
+			__m256 before = _mm256_loadu_ps(x + i - 1);
+			__m256 now = _mm256_loadu_ps(x + i);
+			int mask = _mm256_movemask_ps(_mm256_and_ps(_mm256_cmp_ps(before, l, _CMP_GT_OQ), _mm256_cmp_ps(now, l, _CMP_LE_OQ)));
+			if (mask)
+				return i + __builtin_ctz(mask);
+		}
+	}
+	int k = oXs_find_crossing_scalar(x + i, n - i, x[i - 1], level, rising);
+
+	return (k < 0)? -1 : (int) i + k;
+}
+
+#endif
+
+CrossingKernel oXs_select_crossing_kernel()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return oXs_find_crossing_avx2;
+	if (__builtin_cpu_supports("sse2"))
+		return oXs_find_crossing_sse2;
+#endif
+	return oXs_find_crossing_scalar;
+}
+
+const char* oXs_crossing_kernel_name(CrossingKernel kernel)
+{
+#if defined(__x86_64__) || defined(__i386__)
+	if (kernel == oXs_find_crossing_avx2)
+		return "avx2";
+	if (kernel == oXs_find_crossing_sse2)
+		return "sse2";
+#endif
+	return "scalar";
+}
+
+void oXs_trigger_machine_init(TriggerMachine* machine)
+{
+	machine->find_crossing = oXs_select_crossing_kernel();
+	oXs_trigger_machine_setup(machine, TRIG_EDGE, TRIG_LONGER, true, 0.0, 0.0, 0.0, 0, 0);
+
+	return;
+}
+
+// Times are given in samples; window and slew levels may be given in any
+// order.
+void oXs_trigger_machine_setup(TriggerMachine* machine, trigger_type type, trigger_condition condition, bool rising, double level, double level_high, double hysteresis, unsigned long time_min, unsigned long time_max)
+{
+	machine->type = type;
+	machine->condition = condition;
+	machine->sign = (rising)? 1.0 : -1.0;
+	double low = machine->sign * level;
+	double high = machine->sign * level_high;
+	machine->level = (high < low)? high : low;
+	machine->level_high = (high < low)? low : high;
+	if ((type == TRIG_EDGE) || (type == TRIG_PULSE))
+		machine->level = machine->sign * level;
+	machine->hysteresis = (hysteresis > 0.0)? hysteresis : 0.0;
+	machine->time_min = time_min;
+	machine->time_max = time_max;
+	oXs_trigger_machine_reset(machine);
+
+	return;
+}
+
+static inline bool oXs_trigger_time_matches(const TriggerMachine* machine, unsigned long time)
+{
+	switch (machine->condition) {
+		case TRIG_SHORTER:
+			return time < machine->time_max;
+		case TRIG_LONGER:
+			return time > machine->time_min;
+		default:
+			return (time >= machine->time_min) && (time <= machine->time_max);
+	}
+}
+
+static inline bool oXs_trigger_edge_step(TriggerMachine* m, float v)
+{
+	if (m->state == TRIG_ARMED) {
+		if (v >= m->level) {
+			m->state = TRIG_IDLE;
+			m->crossed_level = m->level;
+			return true;
+		}
+	} else if (v < m->level - m->hysteresis) {
+		m->state = TRIG_ARMED;
+	}
+
+	return false;
+}
+
+static inline bool oXs_trigger_pulse_step(TriggerMachine* m, float v)
+{
+	if (m->state == TRIG_ACTIVE) {
+		m->count++;
+		if (v < m->level - m->hysteresis) {
+			m->state = TRIG_ARMED;
+			m->crossed_level = m->level - m->hysteresis;
+			return oXs_trigger_time_matches(m, m->count);
+		}
+	} else if (m->state == TRIG_ARMED) {
+		if (v >= m->level) {
+			m->state = TRIG_ACTIVE;
+			m->count = 0;
+		}
+	} else if (v < m->level - m->hysteresis) {
+		m->state = TRIG_ARMED;
+	}
+
+	return false;
+}
+
+// Rising means leaving the window, falling entering it: since levels are
+// negated together with samples, the window keeps its meaning, and the
+// direction is told by the sign. When entering, count remembers the side
+// the signal comes from.
+static inline bool oXs_trigger_window_step(TriggerMachine* m, float v)
+{
+	if (m->sign > 0.0) {
+		if (m->state == TRIG_ARMED) {
+			if ((v < m->level) || (v > m->level_high)) {
+				m->state = TRIG_IDLE;
+				m->crossed_level = (v < m->level)? m->level : m->level_high;
+				return true;
+			}
+		} else if ((v >= m->level + m->hysteresis) && (v <= m->level_high - m->hysteresis)) {
+			m->state = TRIG_ARMED;
+		}
+	} else {
+		if (m->state == TRIG_ARMED) {
+			if ((v >= m->level) && (v <= m->level_high)) {
+				m->state = TRIG_IDLE;
+				m->crossed_level = (m->count == 0)? m->level : m->level_high;
+				return true;
+			}
+		} else if ((v < m->level - m->hysteresis) || (v > m->level_high + m->hysteresis)) {
+			m->state = TRIG_ARMED;
+			m->count = (v < m->level)? 0 : 1;
+		}
+	}
+
+	return false;
+}
+
+static inline bool oXs_trigger_slew_step(TriggerMachine* m, float v)
+{
+	if (m->state == TRIG_ACTIVE) {
+		m->count++;
+		if (v >= m->level_high) {
+			m->state = TRIG_IDLE;
+			m->crossed_level = m->level_high;
+			return oXs_trigger_time_matches(m, m->count);
+		}
+		if (v < m->level - m->hysteresis)
+			m->state = TRIG_ARMED;
+	} else if (m->state == TRIG_ARMED) {
+		if (v >= m->level_high) {
+			m->state = TRIG_IDLE;
+			m->crossed_level = m->level_high;
+			return oXs_trigger_time_matches(m, 0);
+		}
+		if (v >= m->level) {
+			m->state = TRIG_ACTIVE;
+			m->count = 0;
+		}
+	} else if (v < m->level - m->hysteresis) {
+		m->state = TRIG_ARMED;
+	}
+
+	return false;
+}
+
+// Returns the index of the first trigger sample in x[0, n), or -1; the
+// samples up to that index (or the whole block) are consumed.
+int oXs_trigger_machine_find(TriggerMachine* machine, const float* x, unsigned int n)
+{
+	if (n == 0)
+		return -1;
+
+	int k = -1;
+	const float sign = machine->sign;
+	if ((machine->type == TRIG_EDGE) && (machine->hysteresis == 0.0)) {
+		k = machine->find_crossing(x, n, machine->previous, sign * machine->level, sign > 0.0);
+		machine->crossed_level = machine->level;
+	} else {
+		unsigned int i = 0;
+		switch (machine->type) {
+			case TRIG_EDGE:
+				while ((i < n) && !oXs_trigger_edge_step(machine, sign * x[i]))
+					i++;
+				break;
+			case TRIG_PULSE:
+				while ((i < n) && !oXs_trigger_pulse_step(machine, sign * x[i]))
+					i++;
+				break;
+			case TRIG_WINDOW:
+				while ((i < n) && !oXs_trigger_window_step(machine, sign * x[i]))
+					i++;
+				break;
+			case TRIG_SLEW:
+				while ((i < n) && !oXs_trigger_slew_step(machine, sign * x[i]))
+					i++;
+				break;
+		}
+		if (i < n)
+			k = i;
+	}
+	if (k < 0) {
+		machine->previous = x[n - 1];
+		return -1;
+	}
+
+	// The crossing lies between the trigger sample and the preceding one;
+	// the ratio does not depend on the sign applied to samples and levels.
+	float before = (k > 0)? x[k - 1] : machine->previous;
+	float fraction = (x[k] - sign * machine->crossed_level) / (x[k] - before);
+	machine->fraction = ((fraction >= 0.0) && (fraction < 1.0))? fraction : 0.0;
+	machine->previous = x[k];
+
+	return k;
+}
+
+void oXs_trigger_scan_init(TriggerScan* scan)
+{
+	scan->completed = 0;
+	scan->dropped = 0;
+	oXs_trigger_scan_reset(scan, 1, 0, 0);
+
+	return;
+}
+
+// Restarts the scan, e.g. when the time scale changes: waveforms still
+// waiting for their post-trigger samples are discarded, and the pending
+// ring is sized to the new trace.
+void oXs_trigger_scan_reset(TriggerScan* scan, unsigned int trace_size, long pre_trigger, unsigned long holdoff)
+{
+	scan->trace_size = trace_size;
+	long capacity = (long) trace_size - std::min(pre_trigger, 0L);
+	scan->pending.resize(std::min(std::max(capacity, 1L), (long) TRIGGER_MAX_PENDING));
+	scan->pending_head = 0;
+	scan->pending_count = 0;
+	oXs_trigger_scan_set_pre_trigger(scan, pre_trigger);
+	scan->holdoff = holdoff;
+	scan->next_trigger = 0;
+	scan->position = 0;
+	scan->has_latest = false;
+	scan->latest_trigger = 0;
+	scan->latest_end = 0;
+	scan->latest_fraction = 0.0;
+
+	return;
+}
+
+// Moves the trigger point within the waveform (or, if negative, before the
+// waveform). Pending waveforms are rescheduled accordingly; those whose
+// window would start before the scan did are dropped.
+void oXs_trigger_scan_set_pre_trigger(TriggerScan* scan, long pre_trigger)
+{
+	if (pre_trigger >= (long) scan->trace_size)
+		pre_trigger = (long) scan->trace_size - 1;
+	scan->pre_trigger = pre_trigger;
+	while ((scan->pending_count > 0) && ((long) scan->pending[scan->pending_head].trigger < pre_trigger))
+		oXs_trigger_scan_pop(scan);
+
+	return;
+}
+
+// Places the window of the latest completed waveform according to the
+// current pre-trigger, if the most recent history_count samples of the
+// history still hold it; latest_end is updated accordingly.
+bool oXs_trigger_scan_recut(TriggerScan* scan, unsigned long history_count)
+{
+	if (!scan->has_latest || ((long) scan->latest_trigger < scan->pre_trigger))
+		return false;
+	long end = oXs_trigger_scan_end(scan, scan->latest_trigger);
+	if ((end > (long) scan->position) || ((long) scan->position - end + scan->trace_size > (long) history_count))
+		return false;
+	scan->latest_end = end;
+
+	return true;
+}
+
+// Settings as seen by the per-sample search the engine used before the
+// block kernels: the previous sample is fetched from the history ring and
+// the trigger settings through a pointer, for every sample.
+struct BenchmarkSettings {
+	unsigned int	trig_chan;
+	bool		trig_rising_edge;
+	double		trig_level;
+};
+
+static bool oXs_benchmark_per_sample(const TraceBuffer* history, const PeriodBlock* block, int j, const BenchmarkSettings* settings)
+{
+	double y_new = block->samples[settings->trig_chan - 1][j];
+	double y_last = oXs_trace_buffer_back(history, settings->trig_chan - 1);
+	if (settings->trig_rising_edge)
+		return (y_last < settings->trig_level) && (y_new >= settings->trig_level);
+	else
+		return (y_last > settings->trig_level) && (y_new <= settings->trig_level);
+}
+
+// Microbenchmark of the trigger search (engine option -B): a noisy sine
+// wave, sampled at 44.1 kHz, is scanned period by period and pushed into a
+// history ring, first with the per-sample search, then with every block
+// kernel the CPU supports. All of them must find the same crossings, at the
+// same samples as the per-sample search: any difference is reported as a
+// mismatch, and makes the benchmark return 1. A fast and a slow signal are
+// used, since vector kernels pay off the most when crossings are sparse.
+int oXs_trigger_benchmark()
+{
+	const unsigned int nr_channels = 2, period_size = 441, nr_periods = 20000, nr_runs = 3;
+	const unsigned int nr_samples = period_size * nr_periods;
+	const double frequencies[2] = {1000.0, 50.0};
+	const float level = 4000.0;
+
+	float* data = (float *) malloc(sizeof(float) * nr_samples * nr_channels);
+	if (data == NULL) {
+		std::cerr << "Could not allocate benchmark data... exiting.\n";
+		exit(1);
+	}
+	TraceBuffer history;
+	oXs_trace_buffer_init(&history, nr_channels);
+	oXs_trace_buffer_reserve(&history, 4 * period_size);
+	PeriodBlock block;
+	block.nr_channels = nr_channels;
+	block.size = period_size;
+	block.gap_frames = 0;
+	BenchmarkSettings settings = {1, true, level};
+	CrossingKernel kernels[3] = {oXs_find_crossing_scalar, NULL, NULL};
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("sse2"))
+		kernels[1] = oXs_find_crossing_sse2;
+	if (__builtin_cpu_supports("avx2"))
+		kernels[2] = oXs_find_crossing_avx2;
+#endif
+	std::vector<unsigned long> positions, reference;
+	int status = 0;
+
+	for (unsigned int f = 0; f < 2; f++) {
+		uint32_t noise_state = 12345;
+		for (unsigned int i = 0; i < nr_samples; i++) {
+			noise_state = noise_state * 1664525u + 1013904223u;
+			float noise = ((float) (noise_state >> 16) / 65536.0f - 0.5f) * 400.0f;
+			data[i] = 8000.0f * sin(2.0 * M_PI * frequencies[f] * i / 44100.0) + noise;
+			data[nr_samples + i] = -data[i];
+		}
+		fprintf(stderr, "Trigger search benchmark: %.0f Hz signal, %u samples, %u channels, period %u.\n", frequencies[f], nr_samples, nr_channels, period_size);
+		double reference_rate = 0.0;
+		for (int variant = -1; variant < 3; variant++) {
+			if ((variant >= 0) && (kernels[variant] == NULL))
+				continue;
+			double best_time = 1e9;
+			for (unsigned int run = 0; run < nr_runs; run++) {
+				oXs_trace_buffer_clear(&history);
+				positions.clear();
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				for (unsigned int p = 0; p < nr_periods; p++) {
+					for (unsigned int c = 0; c < nr_channels; c++)
+						block.samples[c] = data + c * nr_samples + p * period_size;
+					if (variant < 0) {
+						for (unsigned int j = 0; j < period_size; j++) {
+							if ((history.count > 0) && oXs_benchmark_per_sample(&history, &block, j, &settings))
+								positions.push_back(p * period_size + j);
+							oXs_trace_buffer_push_block(&history, &block, j);
+						}
+					} else {
+						const float* x = block.samples[0];
+						float previous = (history.count > 0)? oXs_trace_buffer_back(&history, 0) : NAN;
+						unsigned int j = 0;
+						int k;
+						while ((j < period_size) && ((k = kernels[variant](x + j, period_size - j, previous, level, true)) >= 0)) {
+							positions.push_back(p * period_size + j + k);
+							previous = x[j + k];
+							j += k + 1;
+						}
+						oXs_trace_buffer_push_period(&history, &block);
+					}
+				}
+				double time = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+				if (time < best_time)
+					best_time = time;
+			}
+			double rate = nr_samples / best_time;
+			if (variant < 0) {
+				reference_rate = rate;
+				reference.swap(positions);
+			}
+			const char* name = (variant < 0)? "per-sample (previous)" : oXs_crossing_kernel_name(kernels[variant]);
+			const std::vector<unsigned long> & found = (variant < 0)? reference : positions;
+			fprintf(stderr, "  %-22s %8.1f Msamples/s  x%5.1f  (%lu crossings)\n", name, rate / 1e6, rate / reference_rate, (unsigned long) found.size());
+			if (found != reference) {
+				size_t i = 0;
+				while ((i < found.size()) && (i < reference.size()) && (found[i] == reference[i]))
+					i++;
+				unsigned long sample = (i == found.size())? reference[i] : ((i == reference.size())? found[i] : std::min(found[i], reference[i]));
+				fprintf(stderr, "  MISMATCH: %s found %lu crossings, the per-sample search %lu; first difference at sample %lu.\n",
+					name, (unsigned long) found.size(), (unsigned long) reference.size(), sample);
+				status = 1;
+			}
+		}
+	}
+	std::cerr << "Selected kernel: " << oXs_crossing_kernel_name(oXs_select_crossing_kernel()) << "\n";
+
+	oXs_trace_buffer_free(&history);
+	free(data);
+
+	return status;
+}
@@ -0,0 +1,243 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_TRIGGER_H
+#define XOSCILLOSCOPE_ENGINE_TRIGGER_H
+
+#include <vector>
+#include <cmath>
+#include <climits>
+
+#include "xoscilloscope-engine_buffer.h"
+
+// Level-crossing search over a block of samples of one channel: returns the
+// index of the first sample that reaches the level from below (rising) or
+// from above (falling), or -1. The sample preceding x[0] is passed as
+// previous; NaN samples (gap markers) never take part in a crossing.
+typedef int (*CrossingKernel)(const float*, unsigned int, float, float, bool);
+
+CrossingKernel oXs_select_crossing_kernel();
+const char* oXs_crossing_kernel_name(CrossingKernel);
+int oXs_trigger_benchmark();
+
+enum trigger_type : unsigned int {
+	TRIG_EDGE,
+	TRIG_PULSE,
+	TRIG_WINDOW,
+	TRIG_SLEW
+};
+
+enum trigger_condition : unsigned int {
+	TRIG_SHORTER,
+	TRIG_LONGER,
+	TRIG_BETWEEN
+};
+
+// Auto sweeps fall back to an untriggered trace when no trigger comes
+// within the auto timeout; normal sweeps wait for a trigger indefinitely;
+// single sweeps stop after the first triggered trace, until re-armed.
+enum sweep_mode : unsigned int {
+	SWEEP_AUTO,
+	SWEEP_NORMAL,
+	SWEEP_SINGLE
+};
+
+enum trigger_state : unsigned int {
+	TRIG_IDLE,
+	TRIG_ARMED,
+	TRIG_ACTIVE
+};
+
+// Trigger state machine, fed with the samples of the trigger channel one
+// block at a time; its state carries over from one block to the next.
+//  - edge: the level is crossed, after the signal has been beyond the
+//    hysteresis band (level -/+ hysteresis);
+//  - pulse: a pulse beyond the level ends, its width (in samples) meeting
+//    the time condition; the pulse ends when the signal goes back beyond
+//    the hysteresis band;
+//  - window: the signal leaves (rising) or enters (falling) the window
+//    between level and level_high, the hysteresis shrinking or widening
+//    the window for arming;
+//  - slew: the signal goes from level to level_high (or back, falling),
+//    taking a number of samples meeting the time condition.
+// Falling edges and negative pulses are handled by negating samples and
+// levels (sign = -1), so that every machine only looks for rising ones.
+// Plain edges without hysteresis are searched by the crossing kernel.
+// When the trigger fires, fraction tells how far (in samples, from 0 to 1)
+// before the trigger sample the threshold was actually crossed, by linear
+// interpolation with the preceding sample.
+struct TriggerMachine {
+	trigger_type		type;
+	trigger_condition	condition;
+	float			sign;
+	float			level;
+	float			level_high;
+	float			hysteresis;
+	unsigned long		time_min;
+	unsigned long		time_max;
+	CrossingKernel		find_crossing;
+	float			previous;
+	trigger_state		state;
+	unsigned long		count;
+	float			crossed_level;
+	float			fraction;
+};
+
+void oXs_trigger_machine_init(TriggerMachine*);
+void oXs_trigger_machine_setup(TriggerMachine*, trigger_type, trigger_condition, bool, double, double, double, unsigned long, unsigned long);
+int oXs_trigger_machine_find(TriggerMachine*, const float*, unsigned int);
+
+inline void oXs_trigger_machine_reset(TriggerMachine* machine)
+{
+	machine->previous = NAN;
+	machine->state = TRIG_IDLE;
+	machine->count = 0;
+	machine->fraction = 0.0;
+}
+
+// Streaming trigger scan. Samples are pushed into a history ring that is
+// never cleared between sweeps, so that no sample escapes the trigger
+// search, even while the display is being refreshed. Every trigger found
+// in the stream queues a waveform of trace_size samples, pre_trigger of
+// which precede the trigger sample; a negative pre_trigger delays the
+// waveform past the trigger (delayed trigger). The waveform is complete
+// when its last sample is pushed, i.e. when it coincides with the most
+// recent trace_size samples of the history. Pending waveforms keep their
+// trigger sample, so that the pre-trigger can be changed without
+// restarting the scan. Positions count the samples pushed since the scan
+// was (re)started; completed counts the waveforms captured since the engine
+// was started, and is the figure to maximize. Each waveform keeps the
+// sub-sample position of its trigger, as a fraction of a sample before the
+// trigger sample. After each accepted trigger, further triggers are ignored
+// for holdoff samples. Pending waveforms are queued in a fixed ring, sized
+// at reset to one waveform per sample between a trigger and the end of its
+// waveform (at most TRIGGER_MAX_PENDING); triggers found while the ring is
+// full are counted in dropped, which, like completed, runs since the
+// engine was started.
+#define TRIGGER_MAX_PENDING 65536
+
+struct PendingWaveform {
+	unsigned long	trigger;
+	float		fraction;
+};
+
+struct TriggerScan {
+	unsigned int			trace_size;
+	long				pre_trigger;
+	unsigned long			holdoff;
+	unsigned long			next_trigger;
+	unsigned long			position;
+	std::vector<PendingWaveform>	pending;
+	unsigned int			pending_head;
+	unsigned int			pending_count;
+	bool				has_latest;
+	unsigned long			latest_trigger;
+	unsigned long			latest_end;
+	float				latest_fraction;
+	unsigned long			completed;
+	unsigned long			dropped;
+};
+
+void oXs_trigger_scan_init(TriggerScan*);
+void oXs_trigger_scan_reset(TriggerScan*, unsigned int, long, unsigned long);
+void oXs_trigger_scan_set_pre_trigger(TriggerScan*, long);
+bool oXs_trigger_scan_recut(TriggerScan*, unsigned long);
+
+// Position following the last sample of the waveform triggered at trigger.
+inline long oXs_trigger_scan_end(const TriggerScan* scan, unsigned long trigger)
+{
+	return (long) trigger - scan->pre_trigger + scan->trace_size;
+}
+
+// Block-wise use: triggers are armed at their offset within the samples
+// about to be pushed, the scan is then advanced past the whole block, and
+// completed waveforms are collected one at a time.
+inline void oXs_trigger_scan_arm(TriggerScan* scan, unsigned int offset, float fraction)
+{
+	unsigned long trigger = scan->position + offset;
+	if (((long) trigger >= scan->pre_trigger) && (trigger >= scan->next_trigger)) {
+		scan->next_trigger = trigger + scan->holdoff;
+		if (scan->pending_count == scan->pending.size()) {
+			scan->dropped++;
+			return;
+		}
+		unsigned int tail = scan->pending_head + scan->pending_count;
+		if (tail >= scan->pending.size())
+			tail -= scan->pending.size();
+		scan->pending[tail].trigger = trigger;
+		scan->pending[tail].fraction = fraction;
+		scan->pending_count++;
+	}
+}
+
+inline void oXs_trigger_scan_advance(TriggerScan* scan, unsigned int nr_samples)
+{
+	scan->position += nr_samples;
+}
+
+// Drops the oldest pending waveform.
+inline void oXs_trigger_scan_pop(TriggerScan* scan)
+{
+	if (++scan->pending_head == scan->pending.size())
+		scan->pending_head = 0;
+	scan->pending_count--;
+}
+
+inline bool oXs_trigger_scan_complete(TriggerScan* scan)
+{
+	if ((scan->pending_count == 0) || (oXs_trigger_scan_end(scan, scan->pending[scan->pending_head].trigger) > (long) scan->position))
+		return false;
+	const PendingWaveform* waveform = &(scan->pending[scan->pending_head]);
+	scan->has_latest = true;
+	scan->latest_trigger = waveform->trigger;
+	scan->latest_end = oXs_trigger_scan_end(scan, scan->latest_trigger);
+	scan->latest_fraction = waveform->fraction;
+	oXs_trigger_scan_pop(scan);
+	scan->completed++;
+
+	return true;
+}
+
+// Discards pending waveforms and ignores any further trigger, until the
+// scan is restarted (single sweeps).
+inline void oXs_trigger_scan_stop(TriggerScan* scan)
+{
+	scan->pending_head = 0;
+	scan->pending_count = 0;
+	scan->next_trigger = ULONG_MAX;
+}
+
+// Sample-wise use: to be called once per sample pushed into the history,
+// telling whether that sample fulfils the trigger condition. Returns true
+// when a waveform is completed by this sample.
+inline bool oXs_trigger_scan_step(TriggerScan* scan, bool triggered)
+{
+	if (triggered)
+		oXs_trigger_scan_arm(scan, 0, 0.0);
+	oXs_trigger_scan_advance(scan, 1);
+
+	return oXs_trigger_scan_complete(scan);
+}
+
+#endif
@@ -0,0 +1,332 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <cmath>
+#include <cstdio>
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+#endif
+
+#include "xoscilloscope-engine_voltmeter.h"
+
+static inline void oXs_voltmeter_cross(VoltmeterPass* pass, bool above, bool below, long i)
+{
+	if ((pass->state != 1) && above) {
+		if (pass->state == 0) {
+			if (pass->first < 0)
+				pass->first = i;
+			pass->last = i;
+			pass->crossings++;
+		}
+		pass->state = 1;
+	} else if ((pass->state != 0) && below) {
+		pass->state = 0;
+	}
+
+	return;
+}
+
+static void oXs_voltmeter_scalar(const float* x, unsigned int n, float reference, float hysteresis, VoltmeterPass* pass)
+{
+	double s = 0.0, q = 0.0;
+	float lo = pass->minimum, hi = pass->maximum;
+	for (unsigned int i = 0; i < n; i++) {
+		float d = x[i] - reference;
+		s += d;
+		q += (double) d * d;
+		lo = (x[i] < lo)? x[i] : lo;
+		hi = (x[i] > hi)? x[i] : hi;
+		oXs_voltmeter_cross(pass, d > hysteresis, d < -hysteresis, i);
+	}
+	pass->sum += s;
+	pass->sum_squares += q;
+	pass->minimum = lo;
+	pass->maximum = hi;
+
+	return;
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+// Deviations are summed in double lanes. The crossing state can only change
+// within a vector holding samples beyond the threshold opposite to the
+// current state: only then are its lanes walked through.
+__attribute__((target("sse2")))
+static void oXs_voltmeter_sse2(const float* x, unsigned int n, float reference, float hysteresis, VoltmeterPass* pass)
+{
+	if (n < 8) {
+		oXs_voltmeter_scalar(x, n, reference, hysteresis, pass);
+		return;
+	}
+	__m128 r = _mm_set1_ps(reference), h = _mm_set1_ps(hysteresis), nh = _mm_set1_ps(-hysteresis);
+	__m128 lo = _mm_set1_ps(pass->minimum), hi = _mm_set1_ps(pass->maximum);
+	__m128d s = _mm_setzero_pd(), q = _mm_setzero_pd();
+	unsigned int i = 0;
+	for (; i + 4 <= n; i += 4) {
+		__m128 v = _mm_loadu_ps(x + i);
+		__m128 d = _mm_sub_ps(v, r);
+		__m128d d0 = _mm_cvtps_pd(d), d1 = _mm_cvtps_pd(_mm_movehl_ps(d, d));
+		s = _mm_add_pd(s, _mm_add_pd(d0, d1));
+		q = _mm_add_pd(q, _mm_add_pd(_mm_mul_pd(d0, d0), _mm_mul_pd(d1, d1)));
+		lo = _mm_min_ps(v, lo);
+		hi = _mm_max_ps(v, hi);
+		int above = _mm_movemask_ps(_mm_cmpgt_ps(d, h));
+		int below = _mm_movemask_ps(_mm_cmplt_ps(d, nh));
+		if (((pass->state != 1) && above) || ((pass->state != 0) && below)) {
+			for (unsigned int k = 0; k < 4; k++)
+				oXs_voltmeter_cross(pass, (above >> k) & 1, (below >> k) & 1, i + k);
+		}
+	}
+	double ls[2], lq[2];
+	float la[4], lb[4];
+	_mm_storeu_pd(ls, s);
+	_mm_storeu_pd(lq, q);
+	_mm_storeu_ps(la, lo);
+	_mm_storeu_ps(lb, hi);
+	pass->sum += ls[0] + ls[1];
+	pass->sum_squares += lq[0] + lq[1];
+	for (unsigned int k = 0; k < 4; k++) {
+		pass->minimum = (la[k] < pass->minimum)? la[k] : pass->minimum;
+		pass->maximum = (lb[k] > pass->maximum)? lb[k] : pass->maximum;
+	}
+	VoltmeterPass tail = *pass;
+	tail.first = tail.last = -1;
+	tail.crossings = 0;
+	oXs_voltmeter_scalar(x + i, n - i, reference, hysteresis, &tail);
+	pass->sum = tail.sum;
+	pass->sum_squares = tail.sum_squares;
+	pass->minimum = tail.minimum;
+	pass->maximum = tail.maximum;
+	pass->state = tail.state;
+	if (tail.crossings > 0) {
+		if (pass->first < 0)
+			pass->first = i + tail.first;
+		pass->last = i + tail.last;
+		pass->crossings += tail.crossings;
+	}
+
+	return;
+}
+
+__attribute__((target("avx2")))
+static void oXs_voltmeter_avx2(const float* x, unsigned int n, float reference, float hysteresis, VoltmeterPass* pass)
+{
+	if (n < 16) {
+		oXs_voltmeter_scalar(x, n, reference, hysteresis, pass);
+		return;
+	}
+	__m256 r = _mm256_set1_ps(reference), h = _mm256_set1_ps(hysteresis), nh = _mm256_set1_ps(-hysteresis);
+	__m256 lo = _mm256_set1_ps(pass->minimum), hi = _mm256_set1_ps(pass->maximum);
+	__m256d s = _mm256_setzero_pd(), q = _mm256_setzero_pd();
+	unsigned int i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 v = _mm256_loadu_ps(x + i);
+		__m256 d = _mm256_sub_ps(v, r);
+		__m256d d0 = _mm256_cvtps_pd(_mm256_castps256_ps128(d)), d1 = _mm256_cvtps_pd(_mm256_extractf128_ps(d, 1));
+		s = _mm256_add_pd(s, _mm256_add_pd(d0, d1));
+		q = _mm256_add_pd(q, _mm256_add_pd(_mm256_mul_pd(d0, d0), _mm256_mul_pd(d1, d1)));
+		lo = _mm256_min_ps(v, lo);
+		hi = _mm256_max_ps(v, hi);
+		int above = _mm256_movemask_ps(_mm256_cmp_ps(d, h, _CMP_GT_OQ));
+		int below = _mm256_movemask_ps(_mm256_cmp_ps(d, nh, _CMP_LT_OQ));
+		if (((pass->state != 1) && above) || ((pass->state != 0) && below)) {
+			for (unsigned int k = 0; k < 8; k++)
+				oXs_voltmeter_cross(pass, (above >> k) & 1, (below >> k) & 1, i + k);
+		}
+	}
+	double ls[4], lq[4];
+	float la[8], lb[8];
+	_mm256_storeu_pd(ls, s);
+	_mm256_storeu_pd(lq, q);
+	_mm256_storeu_ps(la, lo);
+	_mm256_storeu_ps(lb, hi);
+	pass->sum += (ls[0] + ls[1]) + (ls[2] + ls[3]);
+	pass->sum_squares += (lq[0] + lq[1]) + (lq[2] + lq[3]);
+	for (unsigned int k = 0; k < 8; k++) {
+		pass->minimum = (la[k] < pass->minimum)? la[k] : pass->minimum;
+		pass->maximum = (lb[k] > pass->maximum)? lb[k] : pass->maximum;
+	}
+	VoltmeterPass tail = *pass;
+	tail.first = tail.last = -1;
+	tail.crossings = 0;
+	oXs_voltmeter_scalar(x + i, n - i, reference, hysteresis, &tail);
+	pass->sum = tail.sum;
+	pass->sum_squares = tail.sum_squares;
+	pass->minimum = tail.minimum;
+	pass->maximum = tail.maximum;
+	pass->state = tail.state;
+	if (tail.crossings > 0) {
+		if (pass->first < 0)
+			pass->first = i + tail.first;
+		pass->last = i + tail.last;
+		pass->crossings += tail.crossings;
+	}
+
+	return;
+}
+
+#endif
+
+VoltmeterKernel oXs_select_voltmeter_kernel()
+{
+#if defined(__x86_64__) || defined(__i386__)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2"))
+		return oXs_voltmeter_avx2;
+	if (__builtin_cpu_supports("sse2"))
+		return oXs_voltmeter_sse2;
+#endif
+	return oXs_voltmeter_scalar;
+}
+
+static void oXs_voltmeter_clear_pass(VoltmeterPass* pass)
+{
+	pass->sum = 0.0;
+	pass->sum_squares = 0.0;
+	pass->minimum = INFINITY;
+	pass->maximum = -INFINITY;
+	pass->crossings = 0;
+	pass->first = pass->last = -1;
+
+	return;
+}
+
+// Closes the current stretch of contiguous samples: its crossings span
+// crossings - 1 whole cycles.
+static void oXs_voltmeter_close_stretch(VoltmeterChannel* channel)
+{
+	if (channel->crossings > 1) {
+		channel->cycles += channel->crossings - 1;
+		channel->cycle_samples += channel->last - channel->first;
+	}
+	channel->crossings = 0;
+	channel->first = channel->last = -1;
+
+	return;
+}
+
+void oXs_voltmeter_reset(Voltmeter* voltmeter, unsigned int nr_channels, unsigned int sample_rate, double interval)
+{
+	voltmeter->kernel = oXs_select_voltmeter_kernel();
+	voltmeter->nr_channels = nr_channels;
+	voltmeter->sample_rate = sample_rate;
+	interval = (interval < VOLTMETER_MIN_INTERVAL)? VOLTMETER_MIN_INTERVAL : ((interval > VOLTMETER_MAX_INTERVAL)? VOLTMETER_MAX_INTERVAL : interval);
+	voltmeter->interval = lround(interval * sample_rate);
+	voltmeter->count = 0;
+	voltmeter->readings = 0;
+	for (unsigned int c = 0; c < MAX_CHANNELS; c++) {
+		VoltmeterChannel* channel = &(voltmeter->channel[c]);
+		channel->reference = 0.0;
+		channel->hysteresis = 0.0;
+		oXs_voltmeter_clear_pass(&(channel->pass));
+		channel->pass.state = -1;
+		channel->crossings = 0;
+		channel->first = channel->last = -1;
+		channel->cycles = 0.0;
+		channel->cycle_samples = 0.0;
+		voltmeter->reading[c].dc = voltmeter->reading[c].rms = 0.0;
+		voltmeter->reading[c].minimum = voltmeter->reading[c].maximum = 0.0;
+		voltmeter->reading[c].frequency = 0.0;
+	}
+
+	return;
+}
+
+// Adds a period; returns true when it completes a reading. The crossing
+// state does not survive gaps, but goes on from a reading to the next.
+bool oXs_voltmeter_push_period(Voltmeter* voltmeter, const PeriodBlock* block)
+{
+	for (unsigned int c = 0; c < voltmeter->nr_channels; c++) {
+		VoltmeterChannel* channel = &(voltmeter->channel[c]);
+		if (block->gap_frames > 0) {
+			oXs_voltmeter_close_stretch(channel);
+			channel->pass.state = -1;
+		}
+		channel->pass.crossings = 0;
+		channel->pass.first = channel->pass.last = -1;
+		voltmeter->kernel(block->samples[c], block->size, channel->reference, channel->hysteresis, &(channel->pass));
+		if (channel->pass.crossings > 0) {
+			if (channel->crossings == 0)
+				channel->first = voltmeter->count + channel->pass.first;
+			channel->last = voltmeter->count + channel->pass.last;
+			channel->crossings += channel->pass.crossings;
+		}
+	}
+	voltmeter->count += block->size;
+	if (voltmeter->count < voltmeter->interval)
+		return false;
+
+	for (unsigned int c = 0; c < voltmeter->nr_channels; c++) {
+		VoltmeterChannel* channel = &(voltmeter->channel[c]);
+		VoltmeterReading* reading = &(voltmeter->reading[c]);
+		double n = (double) voltmeter->count;
+		double mean = channel->pass.sum / n;
+		double variance = channel->pass.sum_squares / n - mean * mean;
+		reading->dc = channel->reference + mean;
+		reading->rms = (variance > 0.0)? sqrt(variance) : 0.0;
+		reading->minimum = channel->pass.minimum;
+		reading->maximum = channel->pass.maximum;
+		oXs_voltmeter_close_stretch(channel);
+		reading->frequency = (channel->cycles > 0.0)? channel->cycles * voltmeter->sample_rate / channel->cycle_samples : 0.0;
+		channel->reference = reading->dc;
+		channel->hysteresis = VOLTMETER_HYSTERESIS * (reading->maximum - reading->minimum);
+		int state = channel->pass.state;
+		oXs_voltmeter_clear_pass(&(channel->pass));
+		channel->pass.state = state;
+		channel->cycles = 0.0;
+		channel->cycle_samples = 0.0;
+	}
+	voltmeter->count = 0;
+	voltmeter->readings++;
+
+	return true;
+}
+
+// One label per channel, stacked from the top of the screen; k converts
+// units into volts (1.0: uncalibrated).
+void oXs_voltmeter_labels(const Voltmeter* voltmeter, std::vector<std::string> & voltmeter_labels, const double* k)
+{
+	unsigned int nr_channels = voltmeter->nr_channels;
+	char frequency[32];
+	char label[256];
+
+	voltmeter_labels.clear();
+	for (unsigned int c = 0; c < nr_channels; c++) {
+		const VoltmeterReading* reading = &(voltmeter->reading[c]);
+		double y = 1.0 - (2.0 * c + 1.0) / (double) nr_channels;
+		int font_size = (nr_channels > 4)? 12 : 18;
+		if (reading->frequency > 0.0)
+			sprintf(frequency, "%.2f Hz", reading->frequency);
+		else
+			sprintf(frequency, "--- Hz");
+		if (k[c] != 1.0) {
+			sprintf(label, "label %u \"Ch%u  DC %+.4f V  RMS %.4f V\\nPk-Pk %.4f V  f %s\" at 0,%g center textcolor rgb '#d0d0d0' font \"mbfont:Courier,%d\"", c + 1, c + 1, k[c] * reading->dc, k[c] * reading->rms, k[c] * (reading->maximum - reading->minimum), frequency, y, font_size);
+		} else {
+			sprintf(label, "label %u \"Ch%u  DC %+.f  RMS %.f (a.u.)\\nPk-Pk %.f (a.u.)  f %s\" at 0,%g center textcolor rgb '#d0d0d0' font \"mbfont:Courier,%d\"", c + 1, c + 1, reading->dc, reading->rms, reading->maximum - reading->minimum, frequency, y, font_size);
+		}
+		voltmeter_labels.push_back(label);
+	}
+
+	return;
+}
@@ -0,0 +1,102 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_VOLTMETER_H
+#define XOSCILLOSCOPE_ENGINE_VOLTMETER_H
+
+#include <vector>
+#include <string>
+
+#include "xoscilloscope-engine_buffer.h"
+
+#define VOLTMETER_DEFAULT_INTERVAL 0.5
+#define VOLTMETER_MIN_INTERVAL 0.05
+#define VOLTMETER_MAX_INTERVAL 10.0
+#define VOLTMETER_HYSTERESIS 0.1
+
+// Accumulates, over n samples, the sum and the sum of squares of their
+// deviations from reference, their minimum and maximum, and their rising
+// crossings of reference: the state (-1 unknown, 0 low, 1 high) goes high
+// above reference + hysteresis and low below reference - hysteresis, and a
+// rising crossing is a transition from low to high. The first and last
+// crossings are given as indices into the n samples (-1 if none).
+struct VoltmeterPass {
+	double		sum;
+	double		sum_squares;
+	float		minimum;
+	float		maximum;
+	int		state;
+	unsigned int	crossings;
+	long		first;
+	long		last;
+};
+
+typedef void (*VoltmeterKernel)(const float*, unsigned int, float, float, VoltmeterPass*);
+
+VoltmeterKernel oXs_select_voltmeter_kernel();
+
+struct VoltmeterReading {
+	double	dc;
+	double	rms;
+	double	minimum;
+	double	maximum;
+	double	frequency;
+};
+
+// Per channel: the reference (the DC level of the previous reading), about
+// which deviations are summed so that the AC RMS does not suffer from
+// cancellation, and the hysteresis of the crossings (a fraction of the
+// previous peak-to-peak amplitude); the accumulators of the current
+// reading; the crossings of the current stretch of contiguous samples, and
+// the cycles and samples spanned by the stretches already closed by gaps.
+struct VoltmeterChannel {
+	float		reference;
+	float		hysteresis;
+	VoltmeterPass	pass;
+	long		first;
+	long		last;
+	unsigned long	crossings;
+	double		cycles;
+	double		cycle_samples;
+};
+
+// Streaming voltmeter: every period is reduced in a single pass, and a
+// reading (DC level, AC-coupled true RMS, extrema and frequency from the
+// rising crossings of the DC level) is completed every `interval` samples.
+struct Voltmeter {
+	VoltmeterKernel		kernel;
+	unsigned int		nr_channels;
+	unsigned int		sample_rate;
+	unsigned long		interval;
+	unsigned long		count;
+	unsigned long		readings;
+	VoltmeterChannel	channel[MAX_CHANNELS];
+	VoltmeterReading	reading[MAX_CHANNELS];
+};
+
+void oXs_voltmeter_reset(Voltmeter*, unsigned int, unsigned int, double);
+bool oXs_voltmeter_push_period(Voltmeter*, const PeriodBlock*);
+void oXs_voltmeter_labels(const Voltmeter*, std::vector<std::string> &, const double*);
+
+#endif
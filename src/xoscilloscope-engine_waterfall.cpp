@@ -0,0 +1,188 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#include <cmath>
+#include <fstream>
+#include <algorithm>
+
+#include "xoscilloscope-engine_gnuplot.h"
+#include "xoscilloscope-engine_waterfall.h"
+
+// As in spectrum mode, the transform size follows the time scale, up to
+// WATERFALL_MAX_SIZE so that the history keeps spanning a few seconds.
+unsigned int oXs_waterfall_size(unsigned int trace_size)
+{
+	unsigned int size = oXs_spectrum_size(trace_size);
+
+	return (size > WATERFALL_MAX_SIZE)? WATERFALL_MAX_SIZE : size;
+}
+
+// Time spanned by the whole image, in seconds.
+double oXs_waterfall_span(unsigned int size, unsigned int sample_rate)
+{
+	return (double) WATERFALL_COLUMNS * (size / WATERFALL_OVERLAP) / sample_rate;
+}
+
+void oXs_waterfall_reset(Waterfall* waterfall, unsigned int channel, unsigned int size, spectrum_window window_type, double scale, unsigned int sample_rate)
+{
+	unsigned int nr_bins = size / 2 + 1;
+	oXs_fft_plan(&waterfall->plan, size);
+	waterfall->gain = oXs_spectrum_window(waterfall->window, window_type, size);
+	waterfall->channel = channel;
+	waterfall->scale = scale;
+	waterfall->dt = 1.0 / (double) sample_rate;
+	waterfall->size = size;
+	waterfall->hop = size / WATERFALL_OVERLAP;
+	waterfall->stride = (nr_bins + WATERFALL_MAX_ROWS - 1) / WATERFALL_MAX_ROWS;
+	waterfall->nr_rows = (nr_bins + waterfall->stride - 1) / waterfall->stride;
+	waterfall->input.assign(size, 0.0);
+	waterfall->input_head = 0;
+	waterfall->input_count = 0;
+	waterfall->since_column = 0;
+	waterfall->frame.resize(size);
+	waterfall->power.resize(nr_bins);
+	waterfall->image.assign(WATERFALL_COLUMNS * waterfall->nr_rows, NAN);
+	waterfall->head = 0;
+	waterfall->columns = 0;
+	waterfall->record.resize((WATERFALL_COLUMNS + 1) * (waterfall->nr_rows + 1));
+
+	return;
+}
+
+static float* oXs_waterfall_next_column(Waterfall* waterfall)
+{
+	float* column = waterfall->image.data() + waterfall->head * waterfall->nr_rows;
+	waterfall->head = (waterfall->head + 1) % WATERFALL_COLUMNS;
+	if (waterfall->columns < WATERFALL_COLUMNS)
+		waterfall->columns++;
+
+	return column;
+}
+
+// Transforms the latest size samples, oldest first, into a new column.
+static void oXs_waterfall_add_column(Waterfall* waterfall)
+{
+	unsigned int size = waterfall->size;
+	unsigned int first = waterfall->input_head;
+	const float* input = waterfall->input.data();
+	float* frame = waterfall->frame.data();
+	std::copy(input + first, input + size, frame);
+	std::copy(input, input + first, frame + size - first);
+	oXs_fft_power(&waterfall->plan, frame, waterfall->window.data(), waterfall->power.data());
+
+	unsigned int nr_bins = size / 2 + 1;
+	const float* power = waterfall->power.data();
+	float* column = oXs_waterfall_next_column(waterfall);
+	for (unsigned int r = 0; r < waterfall->nr_rows; r++) {
+		unsigned int last = std::min((r + 1) * waterfall->stride, nr_bins);
+		double peak = 0.0;
+		for (unsigned int i = r * waterfall->stride; i < last; i++) {
+			double amplitude = sqrt(power[i]) / waterfall->gain;
+			if ((i > 0) && (i < nr_bins - 1))
+				amplitude *= 2.0;
+			peak = std::max(peak, amplitude);
+		}
+		column[r] = oXs_spectrum_db(peak, waterfall->scale);
+	}
+
+	return;
+}
+
+// Appends the samples of the channel to the input ring, taking a column
+// every hop samples once the ring is full. Returns the number of columns
+// added; lost frames restart the ring.
+unsigned int oXs_waterfall_push_period(Waterfall* waterfall, const PeriodBlock* block)
+{
+	unsigned int added = 0;
+	if (block->gap_frames > 0) {
+		if (waterfall->columns > 0) {
+			float* column = oXs_waterfall_next_column(waterfall);
+			std::fill(column, column + waterfall->nr_rows, NAN);
+			added++;
+		}
+		waterfall->input_count = 0;
+		waterfall->since_column = 0;
+	}
+
+	const float* x = block->samples[waterfall->channel];
+	float* input = waterfall->input.data();
+	unsigned int j = 0;
+	while (j < block->size) {
+		unsigned int n = std::min(block->size - j, waterfall->hop - waterfall->since_column);
+		for (unsigned int i = 0; i < n; i++) {
+			input[waterfall->input_head] = x[j + i];
+			if (++waterfall->input_head == waterfall->size)
+				waterfall->input_head = 0;
+		}
+		waterfall->input_count = std::min(waterfall->input_count + n, waterfall->size);
+		waterfall->since_column += n;
+		j += n;
+		if (waterfall->since_column == waterfall->hop) {
+			waterfall->since_column = 0;
+			if (waterfall->input_count == waterfall->size) {
+				oXs_waterfall_add_column(waterfall);
+				added++;
+			}
+		}
+	}
+
+	return added;
+}
+
+// Hands the image to gnuplot as a binary matrix of floats: the first record
+// holds the number of rows and their frequencies, each following one the
+// time of a column (0 for the latest one, negative before) and its rows.
+// Nothing is plotted until two columns are available.
+void oXs_waterfall_plot(FILE* gnuplot_pipe, const char* gnuplot_fifo, Waterfall* waterfall)
+{
+	std::vector< std::vector<double> > dummy;
+	unsigned int nr_rows = waterfall->nr_rows;
+	unsigned int columns = waterfall->columns;
+	if (columns < 2)
+		return;
+
+	float* record = waterfall->record.data();
+	double df = 1.0 / (waterfall->dt * waterfall->size);
+	unsigned int nr_bins = waterfall->size / 2 + 1;
+	record[0] = nr_rows;
+	for (unsigned int r = 0; r < nr_rows; r++) {
+		unsigned int last = std::min((r + 1) * waterfall->stride, nr_bins) - 1;
+		record[r + 1] = 0.5 * (r * waterfall->stride + last) * df;
+	}
+	double column_time = waterfall->hop * waterfall->dt;
+	for (unsigned int i = 0; i < columns; i++) {
+		unsigned int k = (waterfall->head + WATERFALL_COLUMNS - columns + i) % WATERFALL_COLUMNS;
+		float* row = record + (i + 1) * (nr_rows + 1);
+		row[0] = -(double) (columns - 1 - i) * column_time;
+		std::copy(waterfall->image.data() + k * nr_rows, waterfall->image.data() + (k + 1) * nr_rows, row + 1);
+	}
+
+	std::string command = std::string("plot \"") + gnuplot_fifo + "\" binary matrix with image";
+	GnuplotInterface(gnuplot_pipe, gnuplot_fifo, "execute", command.c_str(), dummy);
+	std::ofstream data(gnuplot_fifo, std::ofstream::binary);
+	data.write((const char *) record, sizeof(float) * (columns + 1) * (nr_rows + 1));
+	data.close();
+
+	return;
+}
@@ -0,0 +1,77 @@
+// --------------------------------------------------------------------------
+//
+// This file is part of the RemoteLab software package.
+//
+// Version 1.0 - September 2020
+//
+//
+// The RemoteLab package is free software; you can use it, redistribute it,
+// and/or modify it under the terms of the GNU General Public License
+// version 3 as published by the Free Software Foundation. The full text
+// of the license can be found in the file LICENSE.txt at the top level of
+// the package distribution.
+//
+// Authors:
+//		Alessio Perinelli and Leonardo Ricci
+//		Department of Physics, University of Trento
+//		I-38123 Trento, Italy
+//		alessio.perinelli@unitn.it
+//		leonardo.ricci@unitn.it
+//		nse.physics.unitn.it
+//		https://github.com/LeonardoRicci/RemoteLab
+//
+// --------------------------------------------------------------------------
+
+#ifndef XOSCILLOSCOPE_ENGINE_WATERFALL_H
+#define XOSCILLOSCOPE_ENGINE_WATERFALL_H
+
+#include <cstdio>
+#include <vector>
+
+#include "xoscilloscope-engine_buffer.h"
+#include "xoscilloscope-engine_spectrum.h"
+
+#define WATERFALL_COLUMNS 400
+#define WATERFALL_MAX_ROWS 256
+#define WATERFALL_MAX_SIZE 8192
+#define WATERFALL_OVERLAP 2
+#define WATERFALL_DB_RANGE 120.0
+
+// Spectrogram of one channel: short-time transforms of size samples are
+// taken every hop = size / WATERFALL_OVERLAP samples, as the samples
+// arrive, from the latest size samples held in the input ring. Each one
+// becomes a column of the image, reduced to nr_rows rows (the peak of
+// stride adjacent bins each, in dB). The image is a fixed ring of
+// WATERFALL_COLUMNS columns, head being the next one to be written, so
+// that its memory does not grow however long the display runs; a column of
+// NaN values marks lost frames. record is the buffer handed to gnuplot.
+struct Waterfall {
+	FftPlan			plan;
+	std::vector<float>	window;
+	double			gain;
+	unsigned int		channel;
+	double			scale;
+	double			dt;
+	unsigned int		size;
+	unsigned int		hop;
+	unsigned int		stride;
+	unsigned int		nr_rows;
+	std::vector<float>	input;
+	unsigned int		input_head;
+	unsigned int		input_count;
+	unsigned int		since_column;
+	std::vector<float>	frame;
+	std::vector<float>	power;
+	std::vector<float>	image;
+	unsigned int		head;
+	unsigned int		columns;
+	std::vector<float>	record;
+};
+
+unsigned int oXs_waterfall_size(unsigned int);
+double oXs_waterfall_span(unsigned int, unsigned int);
+void oXs_waterfall_reset(Waterfall*, unsigned int, unsigned int, spectrum_window, double, unsigned int);
+unsigned int oXs_waterfall_push_period(Waterfall*, const PeriodBlock*);
+void oXs_waterfall_plot(FILE*, const char*, Waterfall*);
+
+#endif